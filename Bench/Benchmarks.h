@@ -0,0 +1,32 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <string>
+#include <vector>
+
+// Each benchmark gets the arguments that follow its name on the command line
+// and returns the process exit code.
+
+// Bench pnm [dir] [iterations]
+int pnmBenchmark(const std::vector<std::string>& args);
+
+// Bench instancing [count ...] [--frames N]
+int instancingBenchmark(const std::vector<std::string>& args);
+
+// Bench stereo [count ...] [--frames N]
+int stereoBenchmark(const std::vector<std::string>& args);
+
+// Bench scene [--frames N] [--grid g,...] [--skybox size,...] [--detail segments,...]
+//             [--replay input.log] [--no-single-pass] [--json PATH]
+int sceneBenchmark(const std::vector<std::string>& args);
+
+// Bench mesh [model] [iterations] [--meshes N]
+int meshBenchmark(const std::vector<std::string>& args);
+
+// Bench packing [model]
+int packingBenchmark(const std::vector<std::string>& args);
+
+// Bench optimize [model] [--shuffle]
+int optimizeBenchmark(const std::vector<std::string>& args);
+
+#endif
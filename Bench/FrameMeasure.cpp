@@ -0,0 +1,76 @@
+#include "FrameMeasure.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+static const double PI = 3.14159265358979323846;
+
+std::vector<glm::mat4> gridModels(unsigned int count)
+{
+  const float spacing = 0.3f;
+  unsigned int side = static_cast<unsigned int>(std::ceil(std::cbrt(double(count))));
+  float half = (side - 1) * spacing * 0.5f;
+  glm::mat4 cubeSize = glm::scale(glm::mat4(1.0f), glm::vec3(0.1f));
+  std::vector<glm::mat4> models;
+  models.reserve(count);
+  for (unsigned int i = 0; i < count; i++)
+  {
+    unsigned int x = i % side, y = (i / side) % side, z = i / (side * side);
+    glm::vec3 position(x * spacing - half, y * spacing - half, -0.3f - z * spacing);
+    models.push_back(glm::translate(glm::mat4(1.0f), position) * cubeSize);
+  }
+  return models;
+}
+
+size_t writeSphere(const std::string& path, unsigned int segments, unsigned int objects)
+{
+  unsigned int bands = std::max(2u, segments / 2);
+  unsigned int row = segments + 1;
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file)
+  {
+    return 0;
+  }
+  size_t triangles = 0;
+  for (unsigned int object = 0; object < objects; object++)
+  {
+    // Side by side along x, each its own object and so its own mesh
+    fprintf(file, "o sphere%u\n", object);
+    for (unsigned int band = 0; band <= bands; band++)
+    {
+      double theta = PI * band / bands;
+      for (unsigned int segment = 0; segment <= segments; segment++)
+      {
+        double phi = 2.0 * PI * segment / segments;
+        double x = sin(theta) * cos(phi), y = cos(theta), z = sin(theta) * sin(phi);
+        fprintf(file, "v %f %f %f\nvn %f %f %f\nvt %f %f\n", x + 2.5 * object, y, z, x, y, z,
+                double(segment) / segments, double(band) / bands);
+      }
+    }
+    // The triangles touching a pole would be degenerate and are left out
+    unsigned int first = object * (bands + 1) * row;
+    for (unsigned int band = 0; band < bands; band++)
+    {
+      for (unsigned int segment = 0; segment < segments; segment++)
+      {
+        // OBJ indices start at 1 and count across objects
+        unsigned int a = first + band * row + segment + 1, b = a + row, c = b + 1, d = a + 1;
+        if (band != 0)
+        {
+          fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, c, c, c, d, d, d);
+          ++triangles;
+        }
+        if (band != bands - 1)
+        {
+          fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+          ++triangles;
+        }
+      }
+    }
+  }
+  fclose(file);
+  return triangles;
+}
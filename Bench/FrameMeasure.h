@@ -0,0 +1,78 @@
+#ifndef FRAMEMEASURE_H
+#define FRAMEMEASURE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "GlContext.h"
+#include "GlCallCounter.h"
+
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+
+// Helpers shared by the rendering benchmarks
+
+inline double median(std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+// Nearest-rank percentile, p from 0 to 100
+inline double percentile(std::vector<double> values, double p)
+{
+  std::sort(values.begin(), values.end());
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+  return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+// Same layout as Scene's grid, filled to exactly count cubes
+std::vector<glm::mat4> gridModels(unsigned int count);
+
+// A UV sphere with segments around it and segments / 2 bands from pole to
+// pole, written as an OBJ model with objects separate copies of it. Returns
+// the triangle count, 0 if the file could not be written.
+size_t writeSphere(const std::string& path, unsigned int segments, unsigned int objects = 1);
+
+struct PathTimes
+{
+  double cpuMs;
+  double gpuMs;
+  double glCalls;
+};
+
+// Renders frames + 5 warm-up frames with drawFrame and returns median times per frame
+template <typename DrawFrame>
+PathTimes measure(GlContext& context, unsigned int frames, DrawFrame drawFrame)
+{
+  GpuTimer timer;
+  std::vector<double> cpu, gpu;
+  GlCallCounts callsBegin = glCallCounts();
+  for (unsigned int frame = 0; frame < frames + 5; frame++)
+  {
+    context.bindTarget();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    timer.begin();
+    auto start = std::chrono::steady_clock::now();
+    drawFrame();
+    double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    timer.end();
+    glFinish();
+    double gpuMs = timer.elapsedMs();
+    // The first few frames include shader and driver warm-up
+    if (frame >= 5)
+    {
+      cpu.push_back(cpuMs);
+      gpu.push_back(gpuMs);
+    }
+  }
+  double calls = double((glCallCounts() - callsBegin).total()) / (frames + 5);
+  return PathTimes{median(cpu), median(gpu), calls};
+}
+
+#endif
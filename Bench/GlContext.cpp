@@ -0,0 +1,124 @@
+#include "GlContext.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <direct.h>
+#define chdir _chdir
+#else
+#include <unistd.h>
+#endif
+
+static void errorCallback(int error, const char* description)
+{
+  fprintf(stderr, "GLFW error %d: %s\n", error, description);
+}
+
+GlContext::GlContext() : window_(nullptr), fbo_(0), color_(0), depth_(0), width_(0), height_(0)
+{
+}
+
+GlContext::~GlContext()
+{
+  if (window_)
+  {
+    glDeleteFramebuffers(1, &fbo_);
+    glDeleteRenderbuffers(1, &color_);
+    glDeleteRenderbuffers(1, &depth_);
+    glfwDestroyWindow(window_);
+    glfwTerminate();
+  }
+}
+
+bool GlContext::create(int width, int height, const std::string& dataDirectory)
+{
+  if (chdir(dataDirectory.c_str()) != 0)
+  {
+    fprintf(stderr, "cannot change to %s, run Bench from its project directory\n", dataDirectory.c_str());
+    return false;
+  }
+
+  glfwSetErrorCallback(errorCallback);
+  if (!glfwInit())
+  {
+    return false;
+  }
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  window_ = glfwCreateWindow(64, 64, "Bench", nullptr, nullptr);
+  if (!window_)
+  {
+    glfwTerminate();
+    return false;
+  }
+  glfwMakeContextCurrent(window_);
+  glfwSwapInterval(0);
+#ifndef __APPLE__
+  glewExperimental = GL_TRUE;
+  if (glewInit() != GLEW_OK)
+  {
+    fprintf(stderr, "glewInit failed\n");
+    return false;
+  }
+  glGetError();
+#endif
+
+  width_ = width;
+  height_ = height;
+  glGenFramebuffers(1, &fbo_);
+  glGenRenderbuffers(1, &color_);
+  glGenRenderbuffers(1, &depth_);
+  glBindRenderbuffer(GL_RENDERBUFFER, color_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_);
+  bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (!complete)
+  {
+    fprintf(stderr, "offscreen framebuffer incomplete\n");
+    return false;
+  }
+
+  printf("GL %s on %s\n", (const char*)glGetString(GL_VERSION), (const char*)glGetString(GL_RENDERER));
+  return true;
+}
+
+void GlContext::bindTarget()
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+  glViewport(0, 0, width_, height_);
+}
+
+GpuTimer::GpuTimer() : query_(0)
+{
+  glGenQueries(1, &query_);
+}
+
+GpuTimer::~GpuTimer()
+{
+  glDeleteQueries(1, &query_);
+}
+
+void GpuTimer::begin()
+{
+  glBeginQuery(GL_TIME_ELAPSED, query_);
+}
+
+void GpuTimer::end()
+{
+  glEndQuery(GL_TIME_ELAPSED);
+}
+
+double GpuTimer::elapsedMs()
+{
+  GLuint64 ns = 0;
+  glGetQueryObjectui64v(query_, GL_QUERY_RESULT, &ns);
+  return ns / 1e6;
+}
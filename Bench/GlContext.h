@@ -0,0 +1,57 @@
+#ifndef GLCONTEXT_H
+#define GLCONTEXT_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+
+#include <string>
+
+// A hidden window with the same 4.1 core context Minimal asks for, rendering
+// into an offscreen colour + depth target of a fixed size. Rendering benchmarks
+// load shaders and cubemaps by relative path, so create() also changes into
+// Minimal's directory.
+class GlContext
+{
+public:
+  GlContext();
+  ~GlContext();
+
+  GlContext(const GlContext&) = delete;
+  GlContext& operator=(const GlContext&) = delete;
+
+  bool create(int width, int height, const std::string& dataDirectory = "../Minimal");
+
+  // Binds the offscreen target and sets the viewport to cover it
+  void bindTarget();
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+private:
+  GLFWwindow* window_;
+  GLuint fbo_, color_, depth_;
+  int width_, height_;
+};
+
+// GPU time between begin() and end(). Reading the result waits
+// for the GPU, so read once the frame has been finished.
+class GpuTimer
+{
+public:
+  GpuTimer();
+  ~GpuTimer();
+
+  void begin();
+  void end();
+  double elapsedMs();
+
+private:
+  GLuint query_;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "FrameMeasure.h"
+#include "CameraUniforms.h"
+#include "ShaderLibrary.h"
+#include "TexturedCube.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+int instancingBenchmark(const std::vector<std::string>& args)
+{
+  std::vector<unsigned int> counts;
+  unsigned int frames = 100;
+  for (size_t i = 0; i < args.size(); i++)
+  {
+    if (args[i] == "--frames" && i + 1 < args.size())
+    {
+      frames = std::max(1, atoi(args[++i].c_str()));
+    }
+    else
+    {
+      counts.push_back(static_cast<unsigned int>(std::max(1, atoi(args[i].c_str()))));
+    }
+  }
+  if (counts.empty())
+  {
+    counts = {1, 10, 100, 1000, 10000, 20000, 50000};
+  }
+
+  GlContext context;
+  if (!context.create(1344, 1600))
+  {
+    return 1;
+  }
+  installGlCallCounter();
+  glEnable(GL_DEPTH_TEST);
+
+  {
+    CameraUniforms camera;
+    TexturedCube cube("cube");
+    ShaderProgram& cubeShader = ShaderLibrary::instance().load("texturedcube.vert", "skybox.frag");
+    ShaderProgram& instancedShader = ShaderLibrary::instance().load("texturedcube_instanced.vert", "skybox.frag");
+
+    // Looking down the grid from just behind its front face, as from the default head position
+    glm::mat4 projection = glm::perspective(glm::radians(100.0f), float(context.width()) / context.height(), 0.01f,
+                                            100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.5f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0, 1, 0));
+
+    printf("\n%9s | %30s | %30s | %7s\n", "", "draw per cube", "glDrawArraysInstanced", "");
+    printf("%9s | %9s %9s %10s | %9s %9s %10s | %7s\n", "cubes", "CPU ms", "GPU ms", "GL calls", "CPU ms", "GPU ms",
+           "GL calls", "CPU x");
+    for (unsigned int count : counts)
+    {
+      std::vector<glm::mat4> models = gridModels(count);
+
+      PathTimes loop = measure(context, frames, [&]
+      {
+        camera.update(projection, view);
+        for (const glm::mat4& model : models)
+        {
+          cube.toWorld = model;
+          cube.draw(cubeShader);
+        }
+      });
+
+      cube.toWorld = glm::mat4(1.0f);
+      cube.setInstances(models);
+      PathTimes instanced = measure(context, frames, [&]
+      {
+        camera.update(projection, view);
+        cube.drawInstanced(instancedShader);
+      });
+
+      printf("%9u | %9.3f %9.3f %10.0f | %9.3f %9.3f %10.0f | %7.1f\n", count, loop.cpuMs, loop.gpuMs, loop.glCalls,
+             instanced.cpuMs, instanced.gpuMs, instanced.glCalls, loop.cpuMs / instanced.cpuMs);
+    }
+    printf("\nGL calls counts only GLEW-loaded entry points (not glBindTexture); medians over %u frames\n", frames);
+    ShaderLibrary::instance().clear();
+  }
+  return 0;
+}
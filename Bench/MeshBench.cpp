@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "FrameMeasure.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "Model.h"
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Loads the model, including the upload, and returns the time taken
+static double loadMs(const std::string& path, size_t& meshes, size_t& indices)
+{
+  auto start = std::chrono::steady_clock::now();
+  Model model(path);
+  glFinish();
+  double ms = elapsedMs(start);
+  meshes = model.meshes.size();
+  indices = 0;
+  for (const Mesh& mesh : model.meshes)
+  {
+    indices += mesh.indexCount;
+  }
+  return ms;
+}
+
+static void printTimes(const char* name, const std::vector<double>& times)
+{
+  printf("%-32s median %8.2f ms  min %8.2f ms\n", name, median(times), *std::min_element(times.begin(), times.end()));
+}
+
+int meshBenchmark(const std::vector<std::string>& args)
+{
+  std::string model;
+  int iterations = 5;
+  unsigned int objects = 256;
+  for (size_t i = 0, positional = 0; i < args.size(); i++)
+  {
+    if (args[i] == "--meshes" && i + 1 < args.size())
+    {
+      objects = static_cast<unsigned int>(std::max(1, atoi(args[++i].c_str())));
+    }
+    else if (positional++ == 0)
+    {
+      model = args[i];
+    }
+    else
+    {
+      iterations = std::max(1, atoi(args[i].c_str()));
+    }
+  }
+
+  GlContext context;
+  if (!context.create(64, 64))
+  {
+    return 1;
+  }
+
+  // Without a model, hundreds of small spheres, each its own mesh
+  bool generated = model.empty();
+  if (generated)
+  {
+    model = "mesh.bench.obj";
+    if (writeSphere(model, 48, objects) == 0)
+    {
+      fprintf(stderr, "could not write %s\n", model.c_str());
+      return 1;
+    }
+  }
+  std::string bake = MeshCache::pathFor(model);
+
+  // Each import writes the bake the next load reads, so it is removed before each import
+  std::vector<double> serialTimes, parallelTimes, bakedTimes;
+  size_t meshes[3] = {}, indices[3] = {};
+  for (int iteration = 0; iteration < iterations; iteration++)
+  {
+    remove(bake.c_str());
+    Model::setSerialConversion(true);
+    double serialMs = loadMs(model, meshes[0], indices[0]);
+    remove(bake.c_str());
+    Model::setSerialConversion(false);
+    double parallelMs = loadMs(model, meshes[1], indices[1]);
+    double bakedMs = loadMs(model, meshes[2], indices[2]);
+    serialTimes.push_back(serialMs);
+    parallelTimes.push_back(parallelMs);
+    bakedTimes.push_back(bakedMs);
+    printf("pass %2d: import serial %8.2f ms  parallel %8.2f ms  baked %8.2f ms\n", iteration, serialMs, parallelMs,
+           bakedMs);
+  }
+
+  uint64_t modelSize = 0, bakeSize = 0;
+  int64_t mtime;
+  statFile(model, modelSize, mtime);
+  statFile(bake, bakeSize, mtime);
+  if (generated)
+  {
+    remove(model.c_str());
+    remove(bake.c_str());
+  }
+
+  if (meshes[0] != meshes[1] || meshes[0] != meshes[2] || indices[0] != indices[1] || indices[0] != indices[2])
+  {
+    fprintf(stderr, "the loads disagree: %zu/%zu/%zu meshes, %zu/%zu/%zu indices\n", meshes[0], meshes[1], meshes[2],
+            indices[0], indices[1], indices[2]);
+    return 1;
+  }
+
+  printf("\n%s: %zu meshes, %zu triangles, %.1f MB source, %.1f MB bake, %d passes, %u worker threads\n",
+         model.c_str(), meshes[0], indices[0] / 3, modelSize / (1024.0 * 1024.0), bakeSize / (1024.0 * 1024.0),
+         iterations, WorkerPool::defaultThreadCount());
+  printTimes("Assimp import, serial + bake:", serialTimes);
+  printTimes("Assimp import, parallel + bake:", parallelTimes);
+  printTimes("mapped bake:", bakedTimes);
+  printf("parallel conversion: %.2fx, bake: %.2fx\n", median(serialTimes) / median(parallelTimes),
+         median(serialTimes) / median(bakedTimes));
+  return 0;
+}
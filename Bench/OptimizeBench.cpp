@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "FrameMeasure.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "Model.h"
+
+typedef std::array<unsigned int, 3> Triangle;
+
+static std::vector<Triangle> sortedTriangles(const std::vector<unsigned int>& indices)
+{
+  std::vector<Triangle> triangles;
+  for (size_t i = 0; i + 2 < indices.size(); i += 3)
+  {
+    // Rotated to start at the smallest index, which keeps the winding
+    Triangle t = {indices[i], indices[i + 1], indices[i + 2]};
+    std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+    triangles.push_back(t);
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+// The reordered indices draw the same triangles with the same winding, and the
+// vertex fetch remap of them the same vertices
+static bool sameTriangles(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                          const std::vector<unsigned int>& reordered, const std::vector<Vertex>& fetched,
+                          const std::vector<unsigned int>& fetchedIndices)
+{
+  if (sortedTriangles(indices) != sortedTriangles(reordered) || fetchedIndices.size() != reordered.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < fetchedIndices.size(); i++)
+  {
+    if (memcmp(&vertices[reordered[i]], &fetched[fetchedIndices[i]], sizeof(Vertex)) != 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+struct Totals
+{
+  VertexCacheStats stats[3];
+
+  void add(const VertexCacheStats* s)
+  {
+    for (int i = 0; i < 3; i++)
+    {
+      stats[i].triangles += s[i].triangles;
+      stats[i].vertices += s[i].vertices;
+      stats[i].transforms += s[i].transforms;
+    }
+  }
+};
+
+static void printRow(const char* name, size_t triangles, const VertexCacheStats* s, double ms)
+{
+  printf("%-10s %9zu  ACMR %6.3f %6.3f %6.3f   ATVR %6.3f %6.3f %6.3f", name, triangles, s[0].acmr(), s[1].acmr(),
+         s[2].acmr(), s[0].atvr(), s[1].atvr(), s[2].atvr());
+  if (ms >= 0.0)
+  {
+    printf("  %8.2f ms", ms);
+  }
+  printf("\n");
+}
+
+int optimizeBenchmark(const std::vector<std::string>& args)
+{
+  std::string model;
+  bool shuffle = false;
+  for (const std::string& arg : args)
+  {
+    if (arg == "--shuffle")
+    {
+      shuffle = true;
+    }
+    else
+    {
+      model = arg;
+    }
+  }
+
+  GlContext context;
+  if (!context.create(64, 64))
+  {
+    return 1;
+  }
+
+  // Without a model, a few spheres, each its own mesh
+  bool generated = model.empty();
+  if (generated)
+  {
+    model = "optimize.bench.obj";
+    if (writeSphere(model, 96, 4) == 0)
+    {
+      fprintf(stderr, "could not write %s\n", model.c_str());
+      return 1;
+    }
+  }
+
+  // The meshes as the importer produced them; this rebakes a bake made with other steps
+  std::vector<std::vector<Vertex>> vertices;
+  std::vector<std::vector<unsigned int>> indices;
+  {
+    Model loaded(model, false, true, VertexFormat::Float, MESH_OPTIMIZE_NONE);
+    for (const Mesh& mesh : loaded.meshes)
+    {
+      vertices.push_back(mesh.vertices);
+      indices.push_back(mesh.indices);
+    }
+  }
+  if (generated)
+  {
+    remove(model.c_str());
+    remove(MeshCache::pathFor(model).c_str());
+  }
+
+  // A triangle soup, as some exporters write it
+  if (shuffle)
+  {
+    std::mt19937 random(1234);
+    for (std::vector<unsigned int>& list : indices)
+    {
+      std::vector<Triangle> triangles(list.size() / 3);
+      memcpy(triangles.data(), list.data(), triangles.size() * sizeof(Triangle));
+      std::shuffle(triangles.begin(), triangles.end(), random);
+      memcpy(list.data(), triangles.data(), triangles.size() * sizeof(Triangle));
+    }
+  }
+
+  printf("%s%s, FIFO cache of %u vertices\n", model.c_str(), shuffle ? " (triangles shuffled)" : "",
+         VERTEX_CACHE_SIZE);
+  printf("%-10s %9s  %-4s %6s %6s %6s   %-4s %6s %6s %6s  %11s\n", "mesh", "triangles", "", "import", "cache", "+ovrdr",
+         "", "import", "cache", "+ovrdr", "time");
+  Totals totals;
+  bool ok = true;
+  for (size_t m = 0; m < vertices.size(); m++)
+  {
+    VertexCacheStats s[3];
+    s[0] = analyzeVertexCache(indices[m].data(), indices[m].size(), vertices[m].size());
+
+    // The default steps: vertex cache order, then fetch order
+    std::vector<Vertex> optimized = vertices[m];
+    std::vector<unsigned int> optimizedIndices = indices[m];
+    auto start = std::chrono::steady_clock::now();
+    MeshOptimizationStats stats = optimizeMesh(optimized, optimizedIndices);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    s[1] = stats.after;
+
+    // The same with the overdraw pass in between, and checked against the input
+    std::vector<unsigned int> reordered = indices[m];
+    optimizeVertexCache(reordered.data(), reordered.size(), vertices[m].size());
+    optimizeOverdraw(reordered.data(), reordered.size(), vertices[m].data(), vertices[m].size());
+    std::vector<Vertex> fetched = vertices[m];
+    std::vector<unsigned int> fetchedIndices = reordered;
+    optimizeVertexFetch(fetched, fetchedIndices);
+    s[2] = analyzeVertexCache(fetchedIndices.data(), fetchedIndices.size(), fetched.size());
+    if (!sameTriangles(vertices[m], indices[m], reordered, fetched, fetchedIndices))
+    {
+      fprintf(stderr, "mesh %zu: the optimised order does not draw the same triangles\n", m);
+      ok = false;
+    }
+
+    printRow(std::to_string(m).c_str(), s[0].triangles, s, ms);
+    totals.add(s);
+  }
+  printRow("all", totals.stats[0].triangles, totals.stats, -1.0);
+  return ok ? 0 : 1;
+}
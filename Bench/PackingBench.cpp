@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "FrameMeasure.h"
+#include "MeshCache.h"
+#include "Model.h"
+#include "VertexPacking.h"
+
+static const double PI = 3.14159265358979323846;
+
+// Worst case of each reconstructed attribute against the original
+struct PackingErrors
+{
+  size_t vertices = 0;
+  // Per axis, as a fraction of the bounds on that axis
+  double position = 0.0;
+  // Degrees
+  double normal = 0.0;
+  double tangent = 0.0;
+  double bitangent = 0.0;
+  // Relative to the coordinate's magnitude (absolute below 1)
+  double texCoords = 0.0;
+};
+
+// atan2 of |a x b| and a . b in doubles: acos of a float dot product cannot
+// resolve angles below a few hundredths of a degree
+static double angleDegrees(const glm::vec3& a, const glm::vec3& b)
+{
+  double ax = a.x, ay = a.y, az = a.z, bx = b.x, by = b.y, bz = b.z;
+  double cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+  double sine = std::sqrt(cx * cx + cy * cy + cz * cz);
+  double cosine = ax * bx + ay * by + az * bz;
+  return std::atan2(sine, cosine) * 180.0 / PI;
+}
+
+static double texCoordError(float original, float decoded)
+{
+  return std::fabs(double(original) - decoded) / std::max(1.0, std::fabs(double(original)));
+}
+
+static void measure(const Vertex* vertices, size_t count, PackingErrors& errors)
+{
+  PackedBounds bounds = packedBounds(vertices, count);
+  std::vector<PackedVertex> packed(count);
+  packVertices(vertices, count, bounds, packed.data());
+  for (size_t i = 0; i < count; i++)
+  {
+    const Vertex& v = vertices[i];
+    Vertex u;
+    unpackVertex(packed[i], bounds, u);
+    for (int axis = 0; axis < 3; axis++)
+    {
+      if (bounds.scale[axis] > 0.0f)
+      {
+        errors.position =
+          std::max(errors.position, std::fabs(double(v.Position[axis]) - u.Position[axis]) / bounds.scale[axis]);
+      }
+    }
+    errors.normal = std::max(errors.normal, angleDegrees(v.Normal, u.Normal));
+    errors.tangent = std::max(errors.tangent, angleDegrees(v.Tangent, u.Tangent));
+    errors.bitangent = std::max(errors.bitangent, angleDegrees(v.Bitangent, u.Bitangent));
+    errors.texCoords = std::max(errors.texCoords, std::max(texCoordError(v.TexCoords.x, u.TexCoords.x),
+                                                           texCoordError(v.TexCoords.y, u.TexCoords.y)));
+  }
+  errors.vertices += count;
+}
+
+// Checks one bound, printing the measured error next to it
+static bool check(const char* name, double error, double limit, const char* unit)
+{
+  bool ok = error <= limit;
+  printf("  %-11s max error %12.3g %-8s limit %10.3g  %s\n", name, error, unit, limit, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// orthonormal: every source frame has bitangent = cross(normal, tangent) * +-1,
+// which the packed format must reproduce
+static bool report(const char* name, const PackingErrors& errors, bool orthonormal)
+{
+  printf("%s: %zu vertices\n", name, errors.vertices);
+  // Rounding to the nearest of 65535 steps, plus float error
+  bool ok = check("position", errors.position, 0.5 / 65535.0 + 1e-6, "of bounds");
+  // Octahedral cells of 1/32767 on a side are a few thousandths of a degree across
+  ok = check("normal", errors.normal, 0.01, "degrees") && ok;
+  ok = check("tangent", errors.tangent, 0.01, "degrees") && ok;
+  // Half floats round to 11 significant bits
+  ok = check("tex coords", errors.texCoords, 1.0 / 2048.0, "relative") && ok;
+  // The packed format rebuilds the bitangent as cross(normal, tangent) times the
+  // stored handedness, so it is off by at most the normal's and tangent's errors,
+  // or by 180 degrees if the handedness is lost. A source frame that is not
+  // orthogonal cannot come back exactly, so model data is only reported.
+  if (orthonormal)
+  {
+    ok = check("bitangent", errors.bitangent, 0.02, "degrees") && ok;
+  }
+  else
+  {
+    printf("  %-11s max error %12.3g %-8s (rebuilt as cross(normal, tangent); not orthogonal in the source)\n",
+           "bitangent", errors.bitangent, "degrees");
+  }
+  return ok;
+}
+
+// Every half converts to a float and back unchanged (NaNs stay NaNs)
+static bool checkHalfRoundTrip()
+{
+  unsigned int mismatches = 0;
+  for (unsigned int h = 0; h <= 0xffff; h++)
+  {
+    float f = halfToFloat(static_cast<uint16_t>(h));
+    uint16_t back = floatToHalf(f);
+    bool nan = (h & 0x7c00) == 0x7c00 && (h & 0x3ff) != 0;
+    if (nan ? ((back & 0x7c00) != 0x7c00 || (back & 0x3ff) == 0) : back != h)
+    {
+      ++mismatches;
+    }
+  }
+  printf("half floats: %u of 65536 do not survive a round trip  %s\n", mismatches, mismatches ? "FAILED" : "ok");
+  return mismatches == 0;
+}
+
+// Vertices with random unit normals and tangents, the same handedness mix and
+// texture coordinates in [-4, 4], over a box a thousand times longer than wide
+static std::vector<Vertex> randomVertices(size_t count)
+{
+  std::mt19937 random(1234);
+  std::normal_distribution<float> gaussian;
+  std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+  std::vector<Vertex> vertices(count);
+  for (Vertex& v : vertices)
+  {
+    v.Position = glm::vec3(uniform(random) * 1000.0f, uniform(random), uniform(random));
+    v.Normal = glm::normalize(glm::vec3(gaussian(random), gaussian(random), gaussian(random)));
+    glm::vec3 t = glm::vec3(gaussian(random), gaussian(random), gaussian(random));
+    v.Tangent = glm::normalize(t - v.Normal * glm::dot(v.Normal, t));
+    v.Bitangent = glm::cross(v.Normal, v.Tangent) * (uniform(random) < 0.0f ? -1.0f : 1.0f);
+    v.TexCoords = glm::vec2(uniform(random) * 4.0f, uniform(random) * 4.0f);
+  }
+  return vertices;
+}
+
+int packingBenchmark(const std::vector<std::string>& args)
+{
+  printf("Vertex %zu bytes, PackedVertex %zu bytes (%.1fx smaller)\n\n", sizeof(Vertex), sizeof(PackedVertex),
+         double(sizeof(Vertex)) / sizeof(PackedVertex));
+
+  bool ok = checkHalfRoundTrip();
+
+  std::vector<Vertex> random = randomVertices(1000000);
+  PackingErrors randomErrors;
+  measure(random.data(), random.size(), randomErrors);
+  ok = report("\nrandom vertices", randomErrors, true) && ok;
+
+  // The model's own vertices as Model loads them, kept on the CPU for the comparison
+  GlContext context;
+  if (!context.create(64, 64))
+  {
+    return 1;
+  }
+  std::string model = args.size() > 0 ? args[0] : "";
+  bool generated = model.empty();
+  if (generated)
+  {
+    model = "packing.bench.obj";
+    if (writeSphere(model, 256) == 0)
+    {
+      fprintf(stderr, "could not write %s\n", model.c_str());
+      return 1;
+    }
+  }
+  PackingErrors modelErrors;
+  {
+    Model loaded(model, false, true);
+    for (const Mesh& mesh : loaded.meshes)
+    {
+      measure(mesh.vertices.data(), mesh.vertices.size(), modelErrors);
+    }
+  }
+  if (generated)
+  {
+    remove(model.c_str());
+    remove(MeshCache::pathFor(model).c_str());
+  }
+  ok = report(("\n" + model).c_str(), modelErrors, false) && ok;
+
+  printf("\n%s\n", ok ? "packed vertices within bounds" : "packed vertices out of bounds");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "PnmImage.h"
+
+// The loader TexturedCube.cpp used before PnmImage, kept verbatim as the baseline
+static unsigned char* loadPPMLegacy(const char* filename, int& width, int& height)
+{
+  const int BUFSIZE = 128;
+  FILE* fp;
+  unsigned int read;
+  unsigned char* rawData;
+  char buf[3][BUFSIZE];
+  char* retval_fgets;
+  size_t retval_sscanf;
+
+  if ((fp = fopen(filename, "rb")) == NULL)
+  {
+    width = 0;
+    height = 0;
+    return NULL;
+  }
+
+  // Read magic number:
+  retval_fgets = fgets(buf[0], BUFSIZE, fp);
+
+  // Read width and height:
+  do
+  {
+    retval_fgets = fgets(buf[0], BUFSIZE, fp);
+  }
+  while (buf[0][0] == '#');
+  retval_sscanf = sscanf(buf[0], "%s %s", buf[1], buf[2]);
+  width = atoi(buf[1]);
+  height = atoi(buf[2]);
+
+  // Read maxval:
+  do
+  {
+    retval_fgets = fgets(buf[0], BUFSIZE, fp);
+  }
+  while (buf[0][0] == '#');
+
+  // Read image data:
+  rawData = new unsigned char[width * height * 3];
+  read = fread(rawData, width * height * 3, 1, fp);
+  fclose(fp);
+  if (read != 1)
+  {
+    delete[] rawData;
+    width = 0;
+    height = 0;
+    return NULL;
+  }
+
+  (void)retval_fgets;
+  (void)retval_sscanf;
+  return rawData;
+}
+
+// Reads one byte per cache line, standing in for the driver reading the pixels during glTexImage2D
+static unsigned int touch(const unsigned char* data, size_t size)
+{
+  unsigned int sum = 0;
+  for (size_t i = 0; i < size; i += 64)
+  {
+    sum += data[i];
+  }
+  return sum;
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double median(std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+int pnmBenchmark(const std::vector<std::string>& args)
+{
+  std::string dir = args.size() > 0 ? args[0] : "../Minimal/skybox_left/";
+  int iterations = args.size() > 1 ? std::max(1, atoi(args[1].c_str())) : 10;
+  if (dir.back() != '/' && dir.back() != '\\')
+  {
+    dir += '/';
+  }
+  const char* faces[] = {"left.ppm", "right.ppm", "up.ppm", "down.ppm", "back.ppm", "front.ppm"};
+
+  // The first pass may come from disk rather than the page cache; both loaders
+  // are interleaved per face so neither one gets to warm the cache for the other
+  std::vector<double> legacyTimes, mappedTimes;
+  unsigned int checksum = 0;
+  size_t faceBytes = 0;
+  for (int iteration = 0; iteration < iterations; iteration++)
+  {
+    double legacyMs = 0.0, mappedMs = 0.0;
+    for (const char* face : faces)
+    {
+      std::string path = dir + face;
+
+      auto start = std::chrono::steady_clock::now();
+      int width, height;
+      unsigned char* data = loadPPMLegacy(path.c_str(), width, height);
+      if (!data)
+      {
+        fprintf(stderr, "could not load %s\n", path.c_str());
+        return 1;
+      }
+      checksum += touch(data, size_t(width) * height * 3);
+      delete[] data;
+      legacyMs += elapsedMs(start);
+
+      start = std::chrono::steady_clock::now();
+      PnmImage image;
+      if (!image.open(path))
+      {
+        return 1;
+      }
+      checksum += touch(image.pixels(), image.size());
+      image.close();
+      mappedMs += elapsedMs(start);
+
+      faceBytes = size_t(width) * height * 3;
+    }
+    legacyTimes.push_back(legacyMs);
+    mappedTimes.push_back(mappedMs);
+    printf("pass %2d: legacy %8.2f ms  mapped %8.2f ms\n", iteration, legacyMs, mappedMs);
+  }
+
+  double legacyMedian = median(legacyTimes), mappedMedian = median(mappedTimes);
+  double totalMb = 6.0 * faceBytes / (1024.0 * 1024.0);
+  printf("\n%s: 6 faces, %.1f MB per pass, %d passes (checksum %u)\n", dir.c_str(), totalMb, iterations, checksum);
+  printf("legacy fgets/fread: median %8.2f ms  min %8.2f ms  %7.1f MB/s  %.1f MB heap per face\n", legacyMedian,
+         *std::min_element(legacyTimes.begin(), legacyTimes.end()), totalMb / (legacyMedian / 1000.0),
+         faceBytes / (1024.0 * 1024.0));
+  printf("mapped PnmImage:    median %8.2f ms  min %8.2f ms  %7.1f MB/s  0.0 MB heap per face\n", mappedMedian,
+         *std::min_element(mappedTimes.begin(), mappedTimes.end()), totalMb / (mappedMedian / 1000.0));
+  printf("speedup: %.2fx\n", legacyMedian / mappedMedian);
+  return 0;
+}
@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "FrameMeasure.h"
+#include "CameraUniforms.h"
+#include "CubemapCache.h"
+#include "Cursor.h"
+#include "InputLog.h"
+#include "MeshCache.h"
+#include "MockHmd.h"
+#include "Scene.h"
+#include "ShaderLibrary.h"
+#include "TexturedCube.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// "1,2,3" to {1, 2, 3}
+static std::vector<unsigned int> parseList(const std::string& list)
+{
+  std::vector<unsigned int> values;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ','))
+  {
+    values.push_back(static_cast<unsigned int>(std::max(0, atoi(item.c_str()))));
+  }
+  return values;
+}
+
+static glm::mat4 toGlm(const ovrMatrix4f& m)
+{
+  return glm::transpose(glm::make_mat4(&m.M[0][0]));
+}
+
+static glm::mat4 toGlm(const ovrPosef& pose)
+{
+  const ovrQuatf& q = pose.Orientation;
+  glm::mat4 orientation = glm::mat4_cast(glm::quat(q.w, q.x, q.y, q.z));
+  return glm::translate(glm::mat4(1.0f), glm::vec3(pose.Position.x, pose.Position.y, pose.Position.z)) * orientation;
+}
+
+struct Percentiles
+{
+  double p50, p95, p99;
+};
+
+static Percentiles percentiles(const std::vector<double>& values)
+{
+  return Percentiles{percentile(values, 50.0), percentile(values, 95.0), percentile(values, 99.0)};
+}
+
+struct SceneResult
+{
+  unsigned int grid;
+  unsigned int cubes;
+  unsigned int skyboxSize;
+  unsigned int modelSegments;
+  size_t modelTriangles;
+  Percentiles cpuMs, gpuMs, frameMs;
+  double drawCalls, stateChanges, glCalls;
+};
+
+static void writeJson(FILE* file, const std::string& renderer, const std::string& trace, unsigned int frames,
+                      bool singlePass, const std::vector<SceneResult>& results)
+{
+  auto writePercentiles = [file](const char* name, const Percentiles& p)
+  {
+    fprintf(file, "\"%s\": {\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f}", name, p.p50, p.p95, p.p99);
+  };
+  fprintf(file, "{\n  \"benchmark\": \"scene\",\n  \"renderer\": \"%s\",\n  \"trace\": \"%s\",\n", renderer.c_str(),
+          trace.c_str());
+  fprintf(file, "  \"frames\": %u,\n  \"single_pass\": %s,\n  \"results\": [\n", frames,
+          singlePass ? "true" : "false");
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const SceneResult& r = results[i];
+    fprintf(file,
+            "    {\"grid\": %u, \"cubes\": %u, \"skybox_size\": %u, \"model_segments\": %u, \"model_triangles\": %zu, ",
+            r.grid, r.cubes, r.skyboxSize, r.modelSegments, r.modelTriangles);
+    writePercentiles("cpu_ms", r.cpuMs);
+    fprintf(file, ", ");
+    writePercentiles("gpu_ms", r.gpuMs);
+    fprintf(file, ", ");
+    writePercentiles("frame_ms", r.frameMs);
+    fprintf(file, ", \"draw_calls\": %.1f, \"state_changes\": %.1f, \"gl_calls\": %.1f}%s\n", r.drawCalls,
+            r.stateChanges, r.glCalls, i + 1 < results.size() ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+}
+
+// JSON strings here are file names and driver strings; only quotes and
+// backslashes need escaping
+static std::string jsonEscape(const std::string& text)
+{
+  std::string escaped;
+  for (char c : text)
+  {
+    if (c == '"' || c == '\\')
+    {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+int sceneBenchmark(const std::vector<std::string>& args)
+{
+  std::vector<unsigned int> grids = {0, 10, 22};
+  std::vector<unsigned int> skyboxSizes = {2048, 256};
+  std::vector<unsigned int> modelSegments = {16, 256};
+  unsigned int frames = 300;
+  std::string replayPath;
+  std::string jsonPath = "scene_bench.json";
+  bool singlePass = true;
+  for (size_t i = 0; i < args.size(); i++)
+  {
+    if (args[i] == "--frames" && i + 1 < args.size())
+    {
+      frames = std::max(1, atoi(args[++i].c_str()));
+    }
+    else if (args[i] == "--grid" && i + 1 < args.size())
+    {
+      grids = parseList(args[++i]);
+    }
+    else if (args[i] == "--skybox" && i + 1 < args.size())
+    {
+      skyboxSizes = parseList(args[++i]);
+    }
+    else if (args[i] == "--detail" && i + 1 < args.size())
+    {
+      modelSegments = parseList(args[++i]);
+    }
+    else if (args[i] == "--replay" && i + 1 < args.size())
+    {
+      replayPath = args[++i];
+    }
+    else if (args[i] == "--json" && i + 1 < args.size())
+    {
+      jsonPath = args[++i];
+    }
+    else if (args[i] == "--no-single-pass")
+    {
+      singlePass = false;
+    }
+  }
+
+  // Both are relative to where Bench was started, so open them before the
+  // context changes into Minimal's directory
+  std::unique_ptr<InputReplay> replay;
+  if (!replayPath.empty())
+  {
+    replay = std::make_unique<InputReplay>(replayPath, false);
+    if (replay->frames() == 0)
+    {
+      fprintf(stderr, "%s holds no frames\n", replayPath.c_str());
+      return 1;
+    }
+  }
+  FILE* json = fopen(jsonPath.c_str(), "w");
+  if (!json)
+  {
+    fprintf(stderr, "cannot write %s\n", jsonPath.c_str());
+    return 1;
+  }
+
+  // The mock's default headset: two 1344x1600 eyes with a 90 degree FOV
+  MockHmdConfig config;
+  GlContext context;
+  if (!context.create(config.eyeWidth * 2, config.eyeHeight))
+  {
+    fclose(json);
+    return 1;
+  }
+  installGlCallCounter();
+  glEnable(GL_DEPTH_TEST);
+  std::string renderer = (const char*)glGetString(GL_RENDERER);
+
+  std::vector<SceneResult> results;
+  {
+    MockHmd hmd(config);
+    ovrHmdDesc desc = hmd.hmdDesc();
+    glm::mat4 projections[2];
+    glm::vec4 eyeRects[2];
+    ovrPosef hmdToEye[2];
+    for (int eye = 0; eye < 2; eye++)
+    {
+      ovrEyeRenderDesc erd = hmd.renderDesc(static_cast<ovrEyeType>(eye), desc.DefaultEyeFov[eye]);
+      projections[eye] = toGlm(hmd.projection(erd.Fov, 0.01f, 1000.0f));
+      hmdToEye[eye] = erd.HmdToEyePose;
+      eyeRects[eye] = CameraUniforms::viewportRect(eye * config.eyeWidth, 0, config.eyeWidth, config.eyeHeight,
+                                                   context.width(), context.height());
+    }
+
+    // Lower skybox resolutions are sampled from the mip chain, which only a bake has
+    for (const char* dir : { "skybox_left", "skybox_right", "skybox_custom" })
+    {
+      CubemapCache cache;
+      if (!cache.open(std::string("./") + dir + "/", cubemapFaces()))
+      {
+        printf("Baking %s for its mip chain\n", dir);
+        bakeCubemapDirectory(dir);
+      }
+    }
+
+    CameraUniforms camera;
+    std::vector<std::unique_ptr<Cursor>> cursors;
+    std::vector<size_t> triangles;
+    for (unsigned int segments : modelSegments)
+    {
+      std::string path = "sphere_" + std::to_string(segments) + ".bench.obj";
+      triangles.push_back(writeSphere(path, std::max(3u, segments)));
+      cursors.push_back(std::make_unique<Cursor>(path));
+      remove(path.c_str());
+      remove(MeshCache::pathFor(path).c_str());
+    }
+
+    printf("\n%5s %7s %6s %9s | %27s | %27s | %7s %7s\n", "grid", "cubes", "sky", "model tri", "CPU ms p50/p95/p99",
+           "GPU ms p50/p95/p99", "draws", "state");
+    for (unsigned int grid : grids)
+    {
+      Scene scene(true, grid);
+      for (unsigned int skyboxSize : skyboxSizes)
+      {
+        unsigned int sampledSize = scene.setSkyboxSize(skyboxSize);
+        for (size_t model = 0; model < cursors.size(); model++)
+        {
+          Cursor& cursor = *cursors[model];
+          // Every configuration sees the same motion from its first frame
+          if (replay)
+          {
+            replay->rewind();
+          }
+          GpuTimer timer;
+          std::vector<double> cpu, gpu, frame;
+          GlCallCounts callsBegin = glCallCounts();
+          for (unsigned int i = 0; i < frames + 5; i++)
+          {
+            // The first few frames include shader and driver warm-up
+            if (i == 5)
+            {
+              callsBegin = glCallCounts();
+            }
+
+            ovrTrackingState tracking;
+            if (replay)
+            {
+              FrameInput input;
+              if (!replay->next(input))
+              {
+                replay->rewind();
+                replay->next(input);
+              }
+              tracking = input.tracking;
+            }
+            else
+            {
+              tracking = hmd.trackingState(1.0 + i / double(config.refreshRate), false);
+            }
+            ovrPosef eyePoses[2];
+            hmd.calcEyePoses(tracking.HeadPose.ThePose, hmdToEye, eyePoses);
+            glm::mat4 views[2] = { glm::inverse(toGlm(eyePoses[0])), glm::inverse(toGlm(eyePoses[1])) };
+            const ovrVector3f& hand = tracking.HandPoses[ovrHand_Right].ThePose.Position;
+            glm::vec3 cursorPosition(hand.x, hand.y, hand.z);
+
+            context.bindTarget();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            timer.begin();
+            auto start = std::chrono::steady_clock::now();
+            if (singlePass)
+            {
+              for (int plane = 0; plane < CameraUniforms::CLIP_PLANES; plane++)
+              {
+                glCounted::Enable(GL_CLIP_DISTANCE0 + plane);
+              }
+              camera.updateStereo(projections, views, eyeRects);
+              scene.render(Scene::BOTH_EYES);
+              cursor.render(cursorPosition);
+              for (int plane = 0; plane < CameraUniforms::CLIP_PLANES; plane++)
+              {
+                glCounted::Disable(GL_CLIP_DISTANCE0 + plane);
+              }
+            }
+            else
+            {
+              for (int eye = 0; eye < 2; eye++)
+              {
+                glCounted::Viewport(eye * config.eyeWidth, 0, config.eyeWidth, config.eyeHeight);
+                camera.update(projections[eye], views[eye]);
+                scene.render(eye);
+                cursor.render(cursorPosition);
+              }
+            }
+            auto submitted = std::chrono::steady_clock::now();
+            timer.end();
+            glFinish();
+            double gpuMs = timer.elapsedMs();
+            if (i >= 5)
+            {
+              cpu.push_back(std::chrono::duration<double, std::milli>(submitted - start).count());
+              gpu.push_back(gpuMs);
+              frame.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                                .count());
+            }
+          }
+          GlCallCounts calls = glCallCounts() - callsBegin;
+
+          SceneResult r;
+          r.grid = grid;
+          r.cubes = scene.cubeCount();
+          r.skyboxSize = sampledSize;
+          r.modelSegments = modelSegments[model];
+          r.modelTriangles = triangles[model];
+          r.cpuMs = percentiles(cpu);
+          r.gpuMs = percentiles(gpu);
+          r.frameMs = percentiles(frame);
+          r.drawCalls = double(calls.draws()) / frames;
+          r.stateChanges = double(calls.stateChanges()) / frames;
+          r.glCalls = double(calls.total()) / frames;
+          results.push_back(r);
+          printf("%5u %7u %6u %9zu | %8.3f %8.3f %8.3f | %8.3f %8.3f %8.3f | %7.0f %7.0f\n", r.grid, r.cubes,
+                 r.skyboxSize, r.modelTriangles, r.cpuMs.p50, r.cpuMs.p95, r.cpuMs.p99, r.gpuMs.p50, r.gpuMs.p95,
+                 r.gpuMs.p99, r.drawCalls, r.stateChanges);
+        }
+      }
+    }
+    printf("\nCPU time is submission only (glFinish is outside it); %u frames per row over %s\n", frames,
+           replay ? replayPath.c_str() : "the mock HMD's sway");
+    cursors.clear();
+    ShaderLibrary::instance().clear();
+  }
+
+  writeJson(json, jsonEscape(renderer), jsonEscape(replay ? replayPath : "synthetic"), frames, singlePass, results);
+  fclose(json);
+  printf("Results written to %s\n", jsonPath.c_str());
+  return 0;
+}
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "FrameMeasure.h"
+#include "CameraUniforms.h"
+#include "ShaderLibrary.h"
+#include "Skybox.h"
+#include "TexturedCube.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+int stereoBenchmark(const std::vector<std::string>& args)
+{
+  std::vector<unsigned int> counts;
+  unsigned int frames = 100;
+  for (size_t i = 0; i < args.size(); i++)
+  {
+    if (args[i] == "--frames" && i + 1 < args.size())
+    {
+      frames = std::max(1, atoi(args[++i].c_str()));
+    }
+    else
+    {
+      counts.push_back(static_cast<unsigned int>(std::max(1, atoi(args[i].c_str()))));
+    }
+  }
+  if (counts.empty())
+  {
+    counts = {2, 100, 1000, 10000};
+  }
+
+  // Two 1344x1600 eyes side by side, as in the Rift's swap chain
+  const int eyeWidth = 1344, eyeHeight = 1600;
+  GlContext context;
+  if (!context.create(eyeWidth * 2, eyeHeight))
+  {
+    return 1;
+  }
+  installGlCallCounter();
+  glEnable(GL_DEPTH_TEST);
+
+  {
+    CameraUniforms camera;
+    TexturedCube cube("cube");
+    Skybox skyboxLeft("skybox_left");
+    Skybox skyboxRight("skybox_right");
+    skyboxLeft.toWorld = skyboxRight.toWorld = glm::scale(glm::mat4(1.0f), glm::vec3(5.0f));
+    Skybox* skyboxes[2] = { &skyboxLeft, &skyboxRight };
+    ShaderProgram& cubeShader = ShaderLibrary::instance().load("texturedcube.vert", "skybox.frag");
+    ShaderProgram& instancedShader = ShaderLibrary::instance().load("texturedcube_instanced.vert", "skybox.frag");
+    ShaderProgram& skyboxShader = ShaderLibrary::instance().load("skybox.vert", "skybox.frag");
+
+    // Eyes 64mm apart, looking down the grid from just behind its front face
+    glm::mat4 projections[2], views[2];
+    glm::vec4 eyeRects[2];
+    for (int eye = 0; eye < 2; eye++)
+    {
+      projections[eye] = glm::perspective(glm::radians(100.0f), float(eyeWidth) / eyeHeight, 0.01f, 100.0f);
+      glm::vec3 position((eye ? 0.032f : -0.032f), 0.0f, 0.5f);
+      views[eye] = glm::lookAt(position, position + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0, 1, 0));
+      eyeRects[eye] = CameraUniforms::viewportRect(eye * eyeWidth, 0, eyeWidth, eyeHeight, context.width(),
+                                                   context.height());
+    }
+
+    printf("\n%9s %-10s | %30s | %30s | %7s\n", "", "", "per-eye passes", "single pass", "");
+    printf("%9s %-10s | %9s %9s %10s | %9s %9s %10s | %7s\n", "cubes", "cube draws", "CPU ms", "GPU ms", "GL calls",
+           "CPU ms", "GPU ms", "GL calls", "CPU x");
+    for (unsigned int count : counts)
+    {
+      std::vector<glm::mat4> models = gridModels(count);
+      for (bool instanced : { false, true })
+      {
+        // Scene::render for one camera: the cubes, then the sky for eye (or both)
+        auto drawScene = [&](int eye)
+        {
+          if (instanced)
+          {
+            cube.toWorld = glm::mat4(1.0f);
+            cube.drawInstanced(instancedShader);
+          }
+          else
+          {
+            for (const glm::mat4& model : models)
+            {
+              cube.toWorld = model;
+              cube.draw(cubeShader);
+            }
+          }
+          if (eye >= 0)
+          {
+            skyboxes[eye]->draw(skyboxShader);
+          }
+          else
+          {
+            skyboxLeft.draw(skyboxShader, 0);
+            skyboxRight.draw(skyboxShader, 1);
+          }
+        };
+        if (instanced)
+        {
+          cube.setInstances(models);
+        }
+
+        PathTimes perEye = measure(context, frames, [&]
+        {
+          for (int eye = 0; eye < 2; eye++)
+          {
+            glCounted::Viewport(eye * eyeWidth, 0, eyeWidth, eyeHeight);
+            camera.update(projections[eye], views[eye]);
+            drawScene(eye);
+          }
+        });
+
+        PathTimes singlePass = measure(context, frames, [&]
+        {
+          for (int plane = 0; plane < CameraUniforms::CLIP_PLANES; plane++)
+          {
+            glCounted::Enable(GL_CLIP_DISTANCE0 + plane);
+          }
+          camera.updateStereo(projections, views, eyeRects);
+          drawScene(-1);
+          for (int plane = 0; plane < CameraUniforms::CLIP_PLANES; plane++)
+          {
+            glCounted::Disable(GL_CLIP_DISTANCE0 + plane);
+          }
+        });
+
+        printf("%9u %-10s | %9.3f %9.3f %10.0f | %9.3f %9.3f %10.0f | %7.2f\n", count,
+               instanced ? "instanced" : "per cube", perEye.cpuMs, perEye.gpuMs, perEye.glCalls, singlePass.cpuMs,
+               singlePass.gpuMs, singlePass.glCalls, perEye.cpuMs / singlePass.cpuMs);
+      }
+    }
+    printf("\nCPU time is submission only (glFinish is outside it); medians over %u frames\n", frames);
+    ShaderLibrary::instance().clear();
+  }
+  return 0;
+}
@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Benchmarks.h"
+
+struct Benchmark
+{
+  const char* name;
+  const char* usage;
+  int (*run)(const std::vector<std::string>& args);
+};
+
+static const Benchmark benchmarks[] = {
+  {"pnm", "pnm [dir] [iterations]     PPM face loading, legacy fread loader vs mapped PnmImage", pnmBenchmark},
+  {"instancing", "instancing [count ...] [--frames N]   Scene cubes, one draw per cube vs one instanced draw",
+   instancingBenchmark},
+  {"stereo", "stereo [count ...] [--frames N]       Scene rendered as two per-eye passes vs one single-pass stereo pass",
+   stereoBenchmark},
+  {"scene", "scene [--grid g,...] [--skybox size,...] [--detail segments,...] [--replay PATH] [--json PATH]\n"
+            "    Scene + Cursor swept over cube count, skybox size and model detail, percentiles as JSON",
+   sceneBenchmark},
+  {"mesh", "mesh [model] [iterations] [--meshes N]\n"
+           "    Model loading: serial vs parallel mesh conversion after the Assimp import, and the baked mesh cache",
+   meshBenchmark},
+  {"packing", "packing [model]            Packed vertex precision against the float vertices, fails past its bounds",
+   packingBenchmark},
+  {"optimize", "optimize [model] [--shuffle]\n"
+               "    Vertex cache ACMR/ATVR of each mesh as imported, vertex cache ordered, and with the overdraw pass",
+   optimizeBenchmark},
+};
+
+int main(int argc, char** argv)
+{
+  if (argc > 1)
+  {
+    for (const Benchmark& benchmark : benchmarks)
+    {
+      if (strcmp(argv[1], benchmark.name) == 0)
+      {
+        return benchmark.run(std::vector<std::string>(argv + 2, argv + argc));
+      }
+    }
+  }
+
+  printf("usage: Bench <benchmark> [args]\n");
+  for (const Benchmark& benchmark : benchmarks)
+  {
+    printf("  %s\n", benchmark.usage);
+  }
+  return 1;
+}
@@ -0,0 +1,63 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// Fixed capacity FIFO shared between producer threads and a consumer. Producers
+// block while the queue is full, which keeps the amount of decoded data that is
+// waiting for the consumer bounded. The consumer only ever polls.
+template <typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity), closed_(false)
+  {
+  }
+
+  // Blocks until there is room. Returns false (dropping the item) once closed.
+  bool push(T item)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notFull_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+    if (closed_)
+    {
+      return false;
+    }
+    items_.push_back(std::move(item));
+    return true;
+  }
+
+  bool tryPop(T& item)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (items_.empty())
+    {
+      return false;
+    }
+    item = std::move(items_.front());
+    items_.pop_front();
+    notFull_.notify_one();
+    return true;
+  }
+
+  // Wakes every blocked producer and rejects further pushes.
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    items_.clear();
+    notFull_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable notFull_;
+  std::deque<T> items_;
+  size_t capacity_;
+  bool closed_;
+};
+
+#endif
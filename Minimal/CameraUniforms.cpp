@@ -0,0 +1,69 @@
+#include "CameraUniforms.h"
+#include "ShaderLibrary.h"
+
+const char* const CameraUniforms::BLOCK_NAME = "Camera";
+
+static GLsizei currentEyeCount = 1;
+
+CameraUniforms::CameraUniforms() : buffer_(0), block_()
+{
+  glGenBuffers(1, &buffer_);
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_STREAM_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  ShaderLibrary::instance().bindUniformBlock(BLOCK_NAME, BINDING);
+}
+
+CameraUniforms::~CameraUniforms()
+{
+  glDeleteBuffers(1, &buffer_);
+}
+
+void CameraUniforms::update(const glm::mat4& projection, const glm::mat4& view)
+{
+  block_.projection[0] = projection;
+  block_.view[0] = view;
+  block_.viewProjection[0] = projection * view;
+  block_.eyeRect[0] = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+  upload(1);
+}
+
+void CameraUniforms::updateStereo(const glm::mat4 projection[2], const glm::mat4 view[2], const glm::vec4 eyeRect[2])
+{
+  for (int eye = 0; eye < 2; eye++)
+  {
+    block_.projection[eye] = projection[eye];
+    block_.view[eye] = view[eye];
+    block_.viewProjection[eye] = projection[eye] * view[eye];
+    block_.eyeRect[eye] = eyeRect[eye];
+  }
+  upload(2);
+}
+
+glm::vec4 CameraUniforms::viewportRect(int x, int y, int width, int height, int targetWidth, int targetHeight)
+{
+  float scaleX = static_cast<float>(width) / targetWidth;
+  float scaleY = static_cast<float>(height) / targetHeight;
+  // Centre of the sub-viewport in the target's NDC
+  float centreX = (x + width * 0.5f) / targetWidth * 2.0f - 1.0f;
+  float centreY = (y + height * 0.5f) / targetHeight * 2.0f - 1.0f;
+  return glm::vec4(scaleX, scaleY, centreX, centreY);
+}
+
+GLsizei CameraUniforms::eyeCount()
+{
+  return currentEyeCount;
+}
+
+void CameraUniforms::upload(int eyes)
+{
+  block_.eyeCount = eyes;
+  currentEyeCount = eyes;
+
+  // Respecify rather than overwrite, so the next pass does not wait for the
+  // GPU to finish reading what the previous one wrote
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), &block_, GL_STREAM_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer_);
+}
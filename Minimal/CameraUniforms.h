@@ -0,0 +1,83 @@
+#ifndef CAMERAUNIFORMS_H
+#define CAMERAUNIFORMS_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstdint>
+
+// Matches the std140 Camera block in camera.glsl, which every vertex shader
+// gets spliced in:
+//
+//   layout(std140) uniform Camera {
+//       mat4 projection[2];
+//       mat4 view[2];
+//       mat4 viewProjection[2];
+//       vec4 eyeRect[2];
+//       int eyeCount;
+//   };
+//
+// Each draw is instanced eyeCount times and gl_InstanceID % eyeCount picks the
+// eye. eyeRect maps that eye's clip space into its viewport within the bound
+// one: xy scale, zw offset, both in NDC.
+struct CameraBlock
+{
+  glm::mat4 projection[2];
+  glm::mat4 view[2];
+  glm::mat4 viewProjection[2];
+  glm::vec4 eyeRect[2];
+  int32_t eyeCount;
+  int32_t padding[3];
+};
+
+// The camera, written once per pass and read by every draw in it. Objects only
+// upload their own model matrix.
+class CameraUniforms
+{
+public:
+  static const char* const BLOCK_NAME;
+  static const GLuint BINDING = 0;
+  // gl_ClipDistance planes the shaders write to keep each eye inside its rect
+  static const int CLIP_PLANES = 4;
+
+  // Registers the block with the ShaderLibrary so every program picks up the binding
+  CameraUniforms();
+  ~CameraUniforms();
+
+  CameraUniforms(const CameraUniforms&) = delete;
+  CameraUniforms& operator=(const CameraUniforms&) = delete;
+
+  // One eye filling the viewport. Uploads the block and binds it for the draws that follow.
+  void update(const glm::mat4& projection, const glm::mat4& view);
+
+  // Both eyes in one pass over a viewport covering both of them, each drawn into
+  // its own rect (see viewportRect). The clip planes must be enabled.
+  void updateStereo(const glm::mat4 projection[2], const glm::mat4 view[2], const glm::vec4 eyeRect[2]);
+
+  // eyeRect for a sub-viewport of a target, both in pixels
+  static glm::vec4 viewportRect(int x, int y, int width, int height, int targetWidth, int targetHeight);
+
+  // Eyes in the block that was uploaded last. Every draw multiplies its instance
+  // count by this.
+  static GLsizei eyeCount();
+
+  const CameraBlock& block() const { return block_; }
+
+private:
+  void upload(int eyes);
+
+  GLuint buffer_;
+  CameraBlock block_;
+};
+
+#endif
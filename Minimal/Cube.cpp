@@ -1,4 +1,5 @@
 #include "Cube.h"
+#include "CameraUniforms.h"
 
 // Define the coordinates and indices needed to draw the cube. Note that it is not necessary
 // to use a 2-dimensional array, since the layout in memory is the same as a 1-dimensional array.
@@ -91,7 +92,7 @@ const GLfloat normals[] = {
   0.0f, -1.0f, 0.0f,
 };
 
-Cube::Cube() {
+Cube::Cube() : uniforms({ "model" }) {
   toWorld = glm::mat4(1.0f);
 
   // Create array object and buffers. Remember to delete your buffers when the object is destroyed!
@@ -158,22 +159,18 @@ Cube::~Cube() {
   glDeleteBuffers(1, &normalBuffer);
 }
 
-void Cube::draw(GLuint shaderProgram, const glm::mat4& projection, const glm::mat4& view) {
-  glUseProgram(shaderProgram);
-  // Calculate the combination of the model and view (camera inverse) matrices
-  glm::mat4 modelview = view * toWorld;
-  // We need to calcullate this because modern OpenGL does not keep track of any matrix other than the viewport (D)
-  // Consequently, we need to forward the projection, view, and model matrices to the shader programs
-  // Get the location of the uniform variables "projection" and "modelview"
-  uProjection = glGetUniformLocation(shaderProgram, "projection");
-  uModelview = glGetUniformLocation(shaderProgram, "modelview");
-  // Now send these values to the shader program
-  glUniformMatrix4fv(uProjection, 1, GL_FALSE, &projection[0][0]);
-  glUniformMatrix4fv(uModelview, 1, GL_FALSE, &modelview[0][0]);
+void Cube::draw(ShaderProgram& shaderProgram) {
+  shaderProgram.use();
+  // Projection and view were uploaded once for the whole eye pass in the Camera uniform block,
+  // so all we need to forward is the model matrix.
+  // Look up "model" (only the first time we see this program)
+  uniforms.resolve(shaderProgram);
+  // Now send it to the shader program
+  glUniformMatrix4fv(uniforms[U_MODEL], 1, GL_FALSE, &toWorld[0][0]);
   // Now draw the cube. We simply need to bind the VAO associated with it.
   glBindVertexArray(VAO);
-  // Tell OpenGL to draw with triangles
-  glDrawArrays(GL_TRIANGLES, 0, 3 * 2 * 6); // 3 vertices per triangle, 2 triangles per face, 6 faces
+  // Tell OpenGL to draw with triangles, once for each eye in the pass
+  glDrawArraysInstanced(GL_TRIANGLES, 0, 3 * 2 * 6, CameraUniforms::eyeCount()); // 3 vertices per triangle, 2 triangles per face, 6 faces
   // Unbind the VAO when we're done so we don't accidentally draw extra stuff or tamper with its bound buffers
   glBindVertexArray(0);
 }
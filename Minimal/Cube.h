@@ -15,6 +15,8 @@
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "ShaderLibrary.h"
+
 class Cube {
 public:
   Cube();
@@ -22,13 +24,17 @@ public:
 
   glm::mat4 toWorld;
 
-  void draw(GLuint shaderProgram, const glm::mat4& projection, const glm::mat4& view);
+  // Projection and view come from the Camera uniform block (see CameraUniforms)
+  void draw(ShaderProgram& shaderProgram);
   void update();
   void spin(float);
 
   // These variables are needed for the shader program
   GLuint vertexBuffer, normalBuffer, VAO;
-  GLuint uProjection, uModelview;
+
+private:
+  enum { U_MODEL };
+  UniformLocations uniforms;
 };
 
 #endif
@@ -0,0 +1,277 @@
+#include "CubemapCache.h"
+#include "PnmImage.h"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+const char* const CubemapCache::FILE_NAME = "cubemap.bake";
+
+static const char CACHE_MAGIC[4] = {'C', 'U', 'B', 'E'};
+static const uint32_t CACHE_VERSION = 1;
+static const uint64_t SLICE_ALIGNMENT = 16;
+
+static uint64_t alignUp(uint64_t value)
+{
+  return (value + SLICE_ALIGNMENT - 1) & ~(SLICE_ALIGNMENT - 1);
+}
+
+static uint32_t mipLevelCount(uint32_t width, uint32_t height)
+{
+  uint32_t levels = 1;
+  while (width > 1 || height > 1)
+  {
+    width = std::max(1u, width / 2);
+    height = std::max(1u, height / 2);
+    ++levels;
+  }
+  return levels;
+}
+
+// 2x2 box filter for tightly packed RGB8. Odd edges reuse the last row/column.
+static void downsampleRGB(const unsigned char* src, uint32_t srcWidth, uint32_t srcHeight,
+                          unsigned char* dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+  for (uint32_t y = 0; y < dstHeight; ++y)
+  {
+    const unsigned char* row0 = src + std::min(2 * y, srcHeight - 1) * srcWidth * 3;
+    const unsigned char* row1 = src + std::min(2 * y + 1, srcHeight - 1) * srcWidth * 3;
+    for (uint32_t x = 0; x < dstWidth; ++x)
+    {
+      uint32_t x0 = std::min(2 * x, srcWidth - 1) * 3;
+      uint32_t x1 = std::min(2 * x + 1, srcWidth - 1) * 3;
+      for (uint32_t c = 0; c < 3; ++c)
+      {
+        unsigned int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+        *dst++ = static_cast<unsigned char>((sum + 2) / 4);
+      }
+    }
+  }
+}
+
+CubemapCache::CubemapCache() : header_(nullptr), slices_(nullptr)
+{
+}
+
+bool CubemapCache::open(const std::string& directory, const std::vector<std::string>& faces)
+{
+  header_ = nullptr;
+  slices_ = nullptr;
+  if (!file_.open(directory + FILE_NAME))
+  {
+    return false;
+  }
+
+  const unsigned char* base = file_.data();
+  size_t size = file_.size();
+  if (size < sizeof(CubemapCacheHeader))
+  {
+    std::cerr << "cubemap bake " << directory << FILE_NAME << " is truncated" << std::endl;
+    file_.close();
+    return false;
+  }
+
+  const CubemapCacheHeader* header = reinterpret_cast<const CubemapCacheHeader*>(base);
+  if (memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header->version != CACHE_VERSION ||
+      header->faces != faces.size() || header->width == 0 || header->height == 0 || header->levels == 0 ||
+      header->levels > mipLevelCount(header->width, header->height) || header->internalFormat != GL_RGB8 ||
+      header->format != GL_RGB || header->type != GL_UNSIGNED_BYTE)
+  {
+    std::cerr << "cubemap bake " << directory << FILE_NAME << " has an unknown format" << std::endl;
+    file_.close();
+    return false;
+  }
+
+  size_t tableSize = sizeof(CubemapCacheHeader) + header->faces * sizeof(CubemapCacheSource) +
+    header->levels * header->faces * sizeof(CubemapCacheSlice);
+  if (size < tableSize)
+  {
+    std::cerr << "cubemap bake " << directory << FILE_NAME << " is truncated" << std::endl;
+    file_.close();
+    return false;
+  }
+
+  // A face that is no longer on disk is fine (the bake can ship on its own),
+  // but a face that differs from the one we baked makes the whole bake stale.
+  const CubemapCacheSource* sources = reinterpret_cast<const CubemapCacheSource*>(header + 1);
+  for (unsigned int i = 0; i < faces.size(); i++)
+  {
+    uint64_t faceSize;
+    int64_t faceTime;
+    if (statFile(directory + faces[i], faceSize, faceTime) &&
+        (faceSize != sources[i].size || faceTime != sources[i].mtime))
+    {
+      file_.close();
+      return false;
+    }
+  }
+
+  // upload() hands each slice to glTexImage2D as tightly packed RGB8 of the
+  // slice's size, so that size has to be exactly what the slice holds
+  const CubemapCacheSlice* slices = reinterpret_cast<const CubemapCacheSlice*>(sources + header->faces);
+  for (unsigned int i = 0; i < header->levels * header->faces; i++)
+  {
+    unsigned int level = i / header->faces;
+    if (slices[i].width != std::max(1u, header->width >> level) ||
+        slices[i].height != std::max(1u, header->height >> level) ||
+        slices[i].size != uint64_t(slices[i].width) * slices[i].height * 3)
+    {
+      std::cerr << "cubemap bake " << directory << FILE_NAME << " has a malformed slice" << std::endl;
+      file_.close();
+      return false;
+    }
+    if (slices[i].offset > size || slices[i].size > size - slices[i].offset)
+    {
+      std::cerr << "cubemap bake " << directory << FILE_NAME << " is truncated" << std::endl;
+      file_.close();
+      return false;
+    }
+  }
+
+  header_ = header;
+  slices_ = slices;
+  return true;
+}
+
+const CubemapCacheSlice& CubemapCache::slice(unsigned int level, unsigned int face) const
+{
+  return slices_[level * header_->faces + face];
+}
+
+const unsigned char* CubemapCache::pixels(const CubemapCacheSlice& slice) const
+{
+  return file_.data() + slice.offset;
+}
+
+void CubemapCache::upload() const
+{
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  for (unsigned int level = 0; level < header_->levels; level++)
+  {
+    for (unsigned int face = 0; face < header_->faces; face++)
+    {
+      const CubemapCacheSlice& s = slice(level, face);
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, header_->internalFormat, s.width, s.height, 0,
+                   header_->format, header_->type, pixels(s));
+    }
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, header_->levels - 1);
+}
+
+bool bakeCubemap(const std::string& directory, const std::vector<std::string>& faces)
+{
+  const uint32_t faceCount = static_cast<uint32_t>(faces.size());
+
+  // The first face fixes the size of the whole cubemap, which is all we need
+  // to lay out the file up front and then stream one face at a time into it.
+  PnmImage image;
+  if (!image.open(directory + faces[0]))
+  {
+    return false;
+  }
+  if (image.channels() != 3 || image.bytesPerSample() != 1)
+  {
+    std::cerr << "cubemap bakes need 8 bit RGB faces: " << directory << faces[0] << std::endl;
+    return false;
+  }
+
+  CubemapCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  header.width = image.width();
+  header.height = image.height();
+  header.levels = mipLevelCount(header.width, header.height);
+  header.faces = faceCount;
+  header.internalFormat = GL_RGB8;
+  header.format = GL_RGB;
+  header.type = GL_UNSIGNED_BYTE;
+
+  std::vector<CubemapCacheSource> sources(faceCount);
+  std::vector<CubemapCacheSlice> slices(header.levels * faceCount);
+  uint64_t offset = alignUp(sizeof(CubemapCacheHeader) + sources.size() * sizeof(CubemapCacheSource) +
+    slices.size() * sizeof(CubemapCacheSlice));
+  for (uint32_t level = 0; level < header.levels; level++)
+  {
+    uint32_t levelWidth = std::max(1u, header.width >> level);
+    uint32_t levelHeight = std::max(1u, header.height >> level);
+    for (uint32_t face = 0; face < faceCount; face++)
+    {
+      CubemapCacheSlice& s = slices[level * faceCount + face];
+      s.offset = offset;
+      s.size = uint64_t(levelWidth) * levelHeight * 3;
+      s.width = levelWidth;
+      s.height = levelHeight;
+      offset = alignUp(offset + s.size);
+    }
+  }
+
+  std::string path = directory + CubemapCache::FILE_NAME;
+  std::string tmpPath = path + ".tmp";
+  FILE* fp = fopen(tmpPath.c_str(), "wb");
+  if (!fp)
+  {
+    std::cerr << "error writing cubemap bake " << tmpPath << std::endl;
+    return false;
+  }
+
+  bool ok = true;
+  std::vector<unsigned char> mip, nextMip;
+  for (uint32_t face = 0; face < faceCount && ok; face++)
+  {
+    if (face > 0 && (!image.open(directory + faces[face]) || image.channels() != 3 ||
+                     image.bytesPerSample() != 1 || uint32_t(image.width()) != header.width ||
+                     uint32_t(image.height()) != header.height))
+    {
+      std::cerr << "cubemap face " << directory << faces[face] << " is missing or does not match the first face"
+        << std::endl;
+      ok = false;
+      break;
+    }
+    ok = statFile(directory + faces[face], sources[face].size, sources[face].mtime);
+
+    // Level 0 goes out straight from the mapped face, the rest from the previous level
+    const unsigned char* src = image.pixels();
+    for (uint32_t level = 0; level < header.levels && ok; level++)
+    {
+      const CubemapCacheSlice& s = slices[level * faceCount + face];
+      if (level > 0)
+      {
+        const CubemapCacheSlice& prev = slices[(level - 1) * faceCount + face];
+        nextMip.resize(s.size);
+        downsampleRGB(src, prev.width, prev.height, nextMip.data(), s.width, s.height);
+        mip.swap(nextMip);
+        src = mip.data();
+      }
+      ok = fseek(fp, static_cast<long>(s.offset), SEEK_SET) == 0 && fwrite(src, s.size, 1, fp) == 1;
+    }
+  }
+
+  if (ok)
+  {
+    ok = fseek(fp, 0, SEEK_SET) == 0 &&
+      fwrite(&header, sizeof(header), 1, fp) == 1 &&
+      fwrite(sources.data(), sizeof(CubemapCacheSource), sources.size(), fp) == sources.size() &&
+      fwrite(slices.data(), sizeof(CubemapCacheSlice), slices.size(), fp) == slices.size();
+  }
+  ok = (fclose(fp) == 0) && ok;
+
+  if (!ok)
+  {
+    std::cerr << "error writing cubemap bake " << tmpPath << std::endl;
+    remove(tmpPath.c_str());
+    return false;
+  }
+
+  remove(path.c_str());
+  if (rename(tmpPath.c_str(), path.c_str()) != 0)
+  {
+    std::cerr << "error writing cubemap bake " << path << std::endl;
+    return false;
+  }
+  return true;
+}
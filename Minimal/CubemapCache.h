@@ -0,0 +1,78 @@
+#ifndef CUBEMAPCACHE_H
+#define CUBEMAPCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+// A baked cubemap is a single file next to the source faces holding all six
+// faces with their full mip chains, already in the layout glTexImage2D wants.
+//
+//   CubemapCacheHeader
+//   CubemapCacheSource[faces]          size/mtime of the PPMs it was baked from
+//   CubemapCacheSlice[levels * faces]  level-major: slice = level * faces + face
+//   pixel data, every slice starting on a 16 byte boundary
+//
+// The file is memory mapped at load time and each slice is uploaded straight
+// from the mapping, so startup reads exactly the bytes the GPU needs.
+
+struct CubemapCacheHeader
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t levels;
+  uint32_t faces;
+  uint32_t internalFormat;
+  uint32_t format;
+  uint32_t type;
+  uint32_t reserved;
+};
+
+struct CubemapCacheSource
+{
+  uint64_t size;
+  int64_t mtime;
+};
+
+struct CubemapCacheSlice
+{
+  uint64_t offset;
+  uint64_t size;
+  uint32_t width;
+  uint32_t height;
+};
+
+class CubemapCache
+{
+public:
+  static const char* const FILE_NAME;
+
+  CubemapCache();
+
+  // Maps directory/FILE_NAME. Fails if the bake is missing, malformed or was
+  // made from face files that have since changed on disk.
+  bool open(const std::string& directory, const std::vector<std::string>& faces);
+
+  bool isOpen() const { return header_ != nullptr; }
+  const CubemapCacheHeader& header() const { return *header_; }
+  const CubemapCacheSlice& slice(unsigned int level, unsigned int face) const;
+  const unsigned char* pixels(const CubemapCacheSlice& slice) const;
+
+  // Uploads every level of every face into the cubemap bound to GL_TEXTURE_CUBE_MAP.
+  void upload() const;
+
+private:
+  MappedFile file_;
+  const CubemapCacheHeader* header_;
+  const CubemapCacheSlice* slices_;
+};
+
+// Loads the faces of the cubemap in directory, builds their mip chains and
+// writes directory/CubemapCache::FILE_NAME.
+bool bakeCubemap(const std::string& directory, const std::vector<std::string>& faces);
+
+#endif
@@ -0,0 +1,200 @@
+#include "CubemapLoader.h"
+#include "CubemapCache.h"
+#include "PnmImage.h"
+#include "TexturedCube.h"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <iostream>
+
+// Touches every page of a mapped range on the worker so the GL thread never waits on the disk
+static void prefault(const unsigned char* pixels, size_t size)
+{
+  volatile unsigned char sink = 0;
+  for (size_t offset = 0; offset < size; offset += 4096)
+  {
+    sink ^= pixels[offset];
+  }
+}
+
+CubemapLoader::CubemapLoader(unsigned int threadCount, size_t queueCapacity)
+  : decoded_(queueCapacity), currentRow_(0), hasCurrent_(false), workers_(threadCount)
+{
+}
+
+CubemapLoader::~CubemapLoader()
+{
+  // Unblock workers waiting for room in the queue; the pool joins them next
+  decoded_.close();
+  for (auto& pending : pending_)
+  {
+    glDeleteTextures(1, &pending->texture);
+  }
+}
+
+void CubemapLoader::load(TexturedCube* cube, const std::string& directory)
+{
+  const std::vector<std::string>& faces = cubemapFaces();
+
+  auto pending = std::make_shared<Pending>();
+  pending->cube = cube;
+  pending->directory = directory;
+  pending->width = 0;
+  glGenTextures(1, &pending->texture);
+  pending_.push_back(pending);
+
+  auto cache = std::make_shared<CubemapCache>();
+  if (cache->open(directory, faces))
+  {
+    pending->levels = cache->header().levels;
+    pending->remaining = pending->levels * static_cast<unsigned int>(faces.size());
+    for (unsigned int face = 0; face < faces.size(); face++)
+    {
+      workers_.submit([this, pending, cache, face]
+      {
+        const CubemapCacheHeader& header = cache->header();
+        for (unsigned int level = 0; level < header.levels; level++)
+        {
+          const CubemapCacheSlice& s = cache->slice(level, face);
+          const unsigned char* pixels = cache->pixels(s);
+          prefault(pixels, static_cast<size_t>(s.size));
+          Slice slice{pending, face, level, s.width, s.height, header.internalFormat, header.format, header.type,
+                      false, pixels, static_cast<size_t>(s.size), cache};
+          if (!decoded_.push(std::move(slice)))
+          {
+            return;
+          }
+        }
+      });
+    }
+  }
+  else
+  {
+    pending->levels = 1;
+    pending->remaining = static_cast<unsigned int>(faces.size());
+    for (unsigned int face = 0; face < faces.size(); face++)
+    {
+      std::string path = directory + faces[face];
+      workers_.submit([this, pending, path, face]
+      {
+        auto image = std::make_shared<PnmImage>();
+        if (!image->open(path))
+        {
+          decoded_.push(Slice{pending, face, 0, 0, 0, 0, 0, 0, false, nullptr, 0, nullptr});
+          return;
+        }
+        prefault(image->pixels(), image->size());
+        Slice slice{pending, face, 0, uint32_t(image->width()), uint32_t(image->height()),
+                    image->glInternalFormat(), image->glFormat(), image->glType(), image->swapBytes(),
+                    image->pixels(), image->size(), image};
+        decoded_.push(std::move(slice));
+      });
+    }
+  }
+}
+
+bool CubemapLoader::pump(size_t budgetBytes)
+{
+  size_t uploaded = 0;
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  while (uploaded < budgetBytes)
+  {
+    if (!hasCurrent_)
+    {
+      if (!decoded_.tryPop(current_))
+      {
+        break;
+      }
+      hasCurrent_ = true;
+      currentRow_ = 0;
+    }
+
+    Slice& s = current_;
+    if (!s.pixels)
+    {
+      std::cout << "Cubemap texture failed to load at path: " << s.pending->directory << std::endl;
+      s.pending->failedFaces.push_back(s.face);
+      finishSlice(s);
+      continue;
+    }
+
+    size_t rowBytes = s.size / s.height;
+    uint32_t rows = static_cast<uint32_t>(std::max<size_t>(1, (budgetBytes - uploaded) / rowBytes));
+    rows = std::min(rows, s.height - currentRow_);
+
+    GLenum target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + s.face;
+    glBindTexture(GL_TEXTURE_CUBE_MAP, s.pending->texture);
+    if (currentRow_ == 0)
+    {
+      glTexImage2D(target, s.level, s.internalFormat, s.width, s.height, 0, s.format, s.type, nullptr);
+      if (s.level == 0 && s.pending->width == 0)
+      {
+        Pending& p = *s.pending;
+        p.width = s.width;
+        p.height = s.height;
+        p.internalFormat = s.internalFormat;
+        p.format = s.format;
+        p.type = s.type;
+        p.size = s.size;
+      }
+    }
+    glPixelStorei(GL_UNPACK_SWAP_BYTES, s.swapBytes ? GL_TRUE : GL_FALSE);
+    glTexSubImage2D(target, s.level, 0, currentRow_, s.width, rows, s.format, s.type,
+                    s.pixels + currentRow_ * rowBytes);
+    currentRow_ += rows;
+    uploaded += rows * rowBytes;
+
+    if (currentRow_ == s.height)
+    {
+      finishSlice(s);
+    }
+  }
+  glPixelStorei(GL_UNPACK_SWAP_BYTES, GL_FALSE);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+  return idle();
+}
+
+void CubemapLoader::finishSlice(Slice& slice)
+{
+  std::shared_ptr<Pending> pending = slice.pending;
+  slice = Slice();
+  hasCurrent_ = false;
+
+  if (--pending->remaining > 0)
+  {
+    return;
+  }
+
+  // No face loaded, so nothing to size the map by: the cube keeps drawing the placeholder
+  if (pending->failedFaces.size() == cubemapFaces().size())
+  {
+    glDeleteTextures(1, &pending->texture);
+    pending_.erase(std::find(pending_.begin(), pending_.end(), pending));
+    return;
+  }
+
+  glBindTexture(GL_TEXTURE_CUBE_MAP, pending->texture);
+  // Black faces in place of the missing ones. A face without storage would
+  // leave the map incomplete, and then every face of it samples black.
+  if (!pending->failedFaces.empty())
+  {
+    std::vector<unsigned char> black(pending->size, 0);
+    for (unsigned int face : pending->failedFaces)
+    {
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, pending->internalFormat, pending->width,
+                   pending->height, 0, pending->format, pending->type, black.data());
+    }
+  }
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, pending->levels - 1);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER,
+                  pending->levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+  pending->cube->cubeMap = pending->texture;
+  pending_.erase(std::find(pending_.begin(), pending_.end(), pending));
+}
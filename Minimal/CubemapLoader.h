@@ -0,0 +1,83 @@
+#ifndef CUBEMAPLOADER_H
+#define CUBEMAPLOADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BoundedQueue.h"
+#include "WorkerPool.h"
+
+class TexturedCube;
+
+// Loads cubemaps without stalling the GL thread. Faces are read and decoded on
+// a worker pool and handed back through a bounded queue; the GL thread calls
+// pump() once per frame to upload at most a fixed number of bytes, in row bands
+// so that even a single 2048x2048 face is spread over several frames. Until all
+// of its faces are resident a TexturedCube keeps drawing the placeholder map.
+class CubemapLoader
+{
+public:
+  explicit CubemapLoader(unsigned int threadCount = WorkerPool::defaultThreadCount(), size_t queueCapacity = 6);
+  ~CubemapLoader();
+
+  CubemapLoader(const CubemapLoader&) = delete;
+  CubemapLoader& operator=(const CubemapLoader&) = delete;
+
+  // GL thread. Queues ./directory/ for loading into cube->cubeMap. The cube
+  // must outlive the loader or the load.
+  void load(TexturedCube* cube, const std::string& directory);
+
+  // GL thread. Uploads up to budgetBytes of decoded pixels. Returns true once
+  // every requested cubemap is resident.
+  bool pump(size_t budgetBytes);
+
+  bool idle() const { return pending_.empty(); }
+
+private:
+  struct Pending
+  {
+    TexturedCube* cube;
+    std::string directory;
+    unsigned int texture;
+    unsigned int levels;
+    unsigned int remaining;
+    // Level 0 of the first face uploaded; faces that fail to load are given
+    // the same storage so the map stays complete
+    uint32_t width, height, internalFormat, format, type;
+    size_t size;
+    std::vector<unsigned int> failedFaces;
+  };
+
+  // One level of one face, decoded and ready to upload
+  struct Slice
+  {
+    std::shared_ptr<Pending> pending;
+    unsigned int face;
+    unsigned int level;
+    uint32_t width;
+    uint32_t height;
+    uint32_t internalFormat;
+    uint32_t format;
+    uint32_t type;
+    bool swapBytes;
+    const unsigned char* pixels;
+    size_t size;
+    std::shared_ptr<const void> storage;
+  };
+
+  void finishSlice(Slice& slice);
+
+  BoundedQueue<Slice> decoded_;
+  std::vector<std::shared_ptr<Pending>> pending_;
+  Slice current_;
+  uint32_t currentRow_;
+  bool hasCurrent_;
+
+  // Declared last so the workers are joined before the queue they feed goes away
+  WorkerPool workers_;
+};
+
+#endif
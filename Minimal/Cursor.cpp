@@ -0,0 +1,25 @@
+#include "Cursor.h"
+#include "Model.h"
+
+Cursor::Cursor(const std::string& modelPath, bool packedVertices, unsigned int meshOptimization) {
+	cursor = std::make_unique<Model>(modelPath, false, false, packedVertices ? VertexFormat::Packed : VertexFormat::Float,
+		meshOptimization);
+	shader = &ShaderLibrary::instance().load(cursor->vertexShader("shader_cursor.vert"), "shader_cursor.frag");
+}
+
+Cursor::~Cursor() {
+}
+
+void Cursor::render(glm::vec3 pos) {
+	position = pos;
+	glm::mat4 toWorld = glm::translate(glm::mat4(1.0f), position) * glm::scale(glm::mat4(1.0f), glm::vec3(0.02f));
+	cursor->Draw(*shader, toWorld);
+}
+
+size_t Cursor::indexCount() const {
+	size_t count = 0;
+	for (const Mesh& mesh : cursor->meshes) {
+		count += mesh.indexCount;
+	}
+	return count;
+}
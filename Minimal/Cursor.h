@@ -0,0 +1,45 @@
+#ifndef CURSOR_H
+#define CURSOR_H
+
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/vec3.hpp>
+
+#include <memory>
+#include <string>
+
+#include "MeshOptimizer.h"
+#include "ShaderLibrary.h"
+
+class Model;
+
+// A small model drawn at the dominant hand's controller
+class Cursor {
+
+	// Shared with any other user of the same sources
+	ShaderProgram* shader;
+
+	// Cursor
+	std::unique_ptr<Model> cursor;
+
+	// User's Dominant Hand's Controller Position 
+	glm::vec3 position;
+
+
+public:
+	// packedVertices stores the model in the packed vertex format (see VertexPacking.h);
+	// meshOptimization are the MeshOptimization steps applied when the model is imported
+	explicit Cursor(const std::string& modelPath = "webtrcc.obj", bool packedVertices = false,
+		unsigned int meshOptimization = MESH_OPTIMIZE_DEFAULT);
+	~Cursor();
+
+	/* Render sphere at User's Dominant Hand's Controller Position */
+	void render(glm::vec3 pos);
+
+	// Indices of every mesh of the model, three per triangle
+	size_t indexCount() const;
+
+};
+
+#endif
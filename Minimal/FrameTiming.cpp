@@ -0,0 +1,316 @@
+#include "FrameTiming.h"
+
+#include <algorithm>
+#include <cstdio>
+
+// Stages that issue GL commands; the others only get a CPU time
+static const bool gpuStages[FRAME_STAGES] = { false, false, true, true, true, true, true, true };
+
+const char* frameStageName(FrameStage stage)
+{
+  static const char* const names[FRAME_STAGES] = { "poll",      "update", "left_eye", "right_eye",
+                                                   "both_eyes", "commit", "submit",   "mirror" };
+  return names[static_cast<int>(stage)];
+}
+
+FrameTiming::FrameTiming() : current_(0), created_(Clock::now()), frameBegin_(created_)
+{
+  glGenQueries(QUERY_FRAMES * FRAME_STAGES * 2, &queries_[0][0][0]);
+  for (PendingFrame& pending : pending_)
+  {
+    pending.active = false;
+  }
+}
+
+FrameTiming::~FrameTiming()
+{
+  glDeleteQueries(QUERY_FRAMES * FRAME_STAGES * 2, &queries_[0][0][0]);
+}
+
+double FrameTiming::secondsSince(Clock::time_point time) const
+{
+  return std::chrono::duration<double>(time - created_).count();
+}
+
+void FrameTiming::beginFrame(uint64_t frame)
+{
+  Clock::time_point now = Clock::now();
+  TraceCapture& trace = TraceCapture::instance();
+  if (trace.capturing() && (!trace.gpuCalibrated() || frame % CALIBRATE_FRAMES == 0))
+  {
+    // Taken between two reads of the steady clock; the midpoint is the best guess
+    GLint64 gpuNs = 0;
+    Clock::time_point before = Clock::now();
+    glGetInteger64v(GL_TIMESTAMP, &gpuNs);
+    Clock::time_point after = Clock::now();
+    trace.calibrateGpu(gpuNs, before + (after - before) / 2);
+  }
+
+  PendingFrame& previous = pending_[current_];
+  if (previous.active)
+  {
+    previous.record.frameMs = std::chrono::duration<double, std::milli>(now - frameBegin_).count();
+  }
+
+  // The slot being reused holds the oldest frame in flight, whose queries have
+  // had QUERY_FRAMES - 1 whole frames to complete
+  current_ = (current_ + 1) % QUERY_FRAMES;
+  PendingFrame& pending = pending_[current_];
+  if (pending.active)
+  {
+    publish(pending, false);
+  }
+
+  pending.record = FrameRecord();
+  pending.record.frame = frame;
+  pending.record.startSeconds = secondsSince(now);
+  std::fill(pending.queried, pending.queried + FRAME_STAGES, false);
+  pending.active = true;
+  frameBegin_ = now;
+}
+
+void FrameTiming::beginStage(FrameStage stage)
+{
+  int s = static_cast<int>(stage);
+  if (gpuStages[s])
+  {
+    glQueryCounter(queries_[current_][s][0], GL_TIMESTAMP);
+  }
+  stageBegin_[s] = Clock::now();
+}
+
+void FrameTiming::endStage(FrameStage stage)
+{
+  int s = static_cast<int>(stage);
+  PendingFrame& pending = pending_[current_];
+  pending.record.cpuMs[s] = std::chrono::duration<float, std::milli>(Clock::now() - stageBegin_[s]).count();
+  if (gpuStages[s])
+  {
+    glQueryCounter(queries_[current_][s][1], GL_TIMESTAMP);
+    pending.queried[s] = true;
+  }
+}
+
+void FrameTiming::publish(PendingFrame& pending, bool wait)
+{
+  int slot = static_cast<int>(&pending - pending_);
+  TraceCapture& trace = TraceCapture::instance();
+  for (int s = 0; s < FRAME_STAGES; s++)
+  {
+    if (!pending.queried[s])
+    {
+      continue;
+    }
+    // The end timestamp is the later command of the pair
+    GLint available = GL_TRUE;
+    if (!wait)
+    {
+      glGetQueryObjectiv(queries_[slot][s][1], GL_QUERY_RESULT_AVAILABLE, &available);
+    }
+    if (!available)
+    {
+      pending.record.gpuMs[s] = -1.0f;
+      continue;
+    }
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(queries_[slot][s][0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(queries_[slot][s][1], GL_QUERY_RESULT, &end);
+    pending.record.gpuMs[s] = static_cast<float>((end - begin) / 1e6);
+    if (trace.capturing())
+    {
+      trace.gpuZone(frameStageName(static_cast<FrameStage>(s)), "gpu", begin, end);
+    }
+  }
+  history_.push(pending.record);
+  pending.active = false;
+}
+
+void FrameTiming::flush()
+{
+  glFinish();
+  PendingFrame& last = pending_[current_];
+  if (last.active)
+  {
+    last.record.frameMs = std::chrono::duration<double, std::milli>(Clock::now() - frameBegin_).count();
+  }
+  for (int i = 1; i <= QUERY_FRAMES; i++)
+  {
+    PendingFrame& pending = pending_[(current_ + i) % QUERY_FRAMES];
+    if (pending.active)
+    {
+      publish(pending, true);
+    }
+  }
+}
+
+FrameSummary FrameTiming::summarize(size_t frames) const
+{
+  FrameSummary summary = {};
+  size_t gpuFrames[FRAME_STAGES] = {};
+  uint64_t count = history_.count();
+  uint64_t first = count > frames ? count - frames : 0;
+  for (uint64_t i = first; i < count; i++)
+  {
+    FrameRecord record;
+    if (!history_.read(i, record))
+    {
+      continue;
+    }
+    summary.frames++;
+    summary.frameMs += record.frameMs;
+    summary.maxFrameMs = std::max(summary.maxFrameMs, record.frameMs);
+    for (int s = 0; s < FRAME_STAGES; s++)
+    {
+      summary.cpuMs[s] += record.cpuMs[s];
+      if (record.gpuMs[s] >= 0.0f)
+      {
+        summary.gpuMs[s] += record.gpuMs[s];
+        gpuFrames[s]++;
+      }
+    }
+  }
+  if (summary.frames)
+  {
+    summary.frameMs /= summary.frames;
+    for (int s = 0; s < FRAME_STAGES; s++)
+    {
+      summary.cpuMs[s] /= summary.frames;
+      summary.gpuMs[s] = gpuFrames[s] ? summary.gpuMs[s] / gpuFrames[s] : 0.0;
+    }
+  }
+  return summary;
+}
+
+bool FrameTiming::writeCsv(const std::string& path) const
+{
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file)
+  {
+    printf("Unable to write frame timings to %s\n", path.c_str());
+    return false;
+  }
+  fprintf(file, "frame,start_s,frame_ms");
+  for (int s = 0; s < FRAME_STAGES; s++)
+  {
+    const char* name = frameStageName(static_cast<FrameStage>(s));
+    fprintf(file, ",%s_cpu_ms,%s_gpu_ms", name, name);
+  }
+  fprintf(file, "\n");
+
+  uint64_t count = history_.count();
+  uint64_t first = count > HISTORY ? count - HISTORY : 0;
+  size_t written = 0;
+  for (uint64_t i = first; i < count; i++)
+  {
+    FrameRecord record;
+    if (!history_.read(i, record))
+    {
+      continue;
+    }
+    fprintf(file, "%llu,%.6f,%.4f", static_cast<unsigned long long>(record.frame), record.startSeconds,
+            record.frameMs);
+    for (int s = 0; s < FRAME_STAGES; s++)
+    {
+      fprintf(file, ",%.4f,%.4f", record.cpuMs[s], record.gpuMs[s]);
+    }
+    fprintf(file, "\n");
+    written++;
+  }
+  fclose(file);
+  printf("Wrote %u frame timings to %s\n", static_cast<unsigned int>(written), path.c_str());
+  return true;
+}
+
+static void fillRect(int x, int y, int width, int height, float r, float g, float b)
+{
+  if (width <= 0 || height <= 0)
+  {
+    return;
+  }
+  glScissor(x, y, width, height);
+  glClearColor(r, g, b, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void FrameTiming::drawOverlay(const FrameSummary& summary, int width, int height, double budgetMs)
+{
+  static const float colors[FRAME_STAGES][3] = {
+    { 0.6f, 0.6f, 0.6f }, // poll
+    { 0.9f, 0.6f, 0.1f }, // update
+    { 0.2f, 0.4f, 1.0f }, // left eye
+    { 0.1f, 0.8f, 0.8f }, // right eye
+    { 0.4f, 0.3f, 1.0f }, // both eyes
+    { 0.8f, 0.2f, 0.8f }, // commit
+    { 0.9f, 0.2f, 0.2f }, // submit
+    { 0.2f, 0.8f, 0.2f }, // mirror
+  };
+  if (!summary.frames || width <= 0 || height <= 0 || budgetMs <= 0.0)
+  {
+    return;
+  }
+
+  GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+  GLint scissorBox[4];
+  GLfloat clearColor[4];
+  glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+  glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+  glEnable(GL_SCISSOR_TEST);
+
+  // The budget sits in the middle, so frames up to twice as long still fit
+  const double pixelsPerMs = width / (2.0 * budgetMs);
+  const int margin = 4;
+  const int bar = std::max(4, height / 60);
+  const int gpuY = margin;
+  const int cpuY = gpuY + bar + margin;
+  fillRect(0, 0, width, cpuY + bar + margin, 0.1f, 0.1f, 0.1f);
+
+  for (int row = 0; row < 2; row++)
+  {
+    const double* ms = row == 0 ? summary.cpuMs : summary.gpuMs;
+    int y = row == 0 ? cpuY : gpuY;
+    double at = 0.0;
+    for (int s = 0; s < FRAME_STAGES; s++)
+    {
+      int x0 = static_cast<int>(at * pixelsPerMs);
+      at += ms[s];
+      int x1 = std::min(width, static_cast<int>(at * pixelsPerMs));
+      fillRect(x0, y, x1 - x0, bar, colors[s][0], colors[s][1], colors[s][2]);
+    }
+    // The rest of the frame time, outside every stage
+    if (row == 0)
+    {
+      int x0 = static_cast<int>(at * pixelsPerMs);
+      int x1 = std::min(width, static_cast<int>(summary.frameMs * pixelsPerMs));
+      fillRect(x0, y, x1 - x0, bar, 0.3f, 0.3f, 0.3f);
+    }
+  }
+  fillRect(static_cast<int>(budgetMs * pixelsPerMs) - 1, 0, 2, cpuY + bar + margin, 1.0f, 1.0f, 1.0f);
+
+  glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+  glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+  if (!scissorTest)
+  {
+    glDisable(GL_SCISSOR_TEST);
+  }
+}
+
+std::string formatFrameSummary(const FrameSummary& summary)
+{
+  char item[64];
+  snprintf(item, sizeof(item), "%.2f ms/frame (max %.2f)", summary.frameMs, summary.maxFrameMs);
+  std::string text = item;
+  for (int row = 0; row < 2; row++)
+  {
+    const double* ms = row == 0 ? summary.cpuMs : summary.gpuMs;
+    text += row == 0 ? "  CPU" : "  GPU";
+    for (int s = 0; s < FRAME_STAGES; s++)
+    {
+      if (ms[s] > 0.0)
+      {
+        snprintf(item, sizeof(item), " %s %.2f", frameStageName(static_cast<FrameStage>(s)), ms[s]);
+        text += item;
+      }
+    }
+  }
+  return text;
+}
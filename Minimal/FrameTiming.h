@@ -0,0 +1,167 @@
+#ifndef FRAMETIMING_H
+#define FRAMETIMING_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "SpscHistory.h"
+#include "Trace.h"
+
+// The parts of a frame that are timed, in the order they run
+enum class FrameStage
+{
+  Poll,
+  Update,
+  LeftEye,
+  RightEye,
+  // Single-pass stereo renders both eyes in one stage
+  BothEyes,
+  Commit,
+  Submit,
+  Mirror,
+  Count
+};
+
+static const int FRAME_STAGES = static_cast<int>(FrameStage::Count);
+
+const char* frameStageName(FrameStage stage);
+
+// Times of one frame. A stage that did not run has 0 for both times; gpuMs is
+// -1 when its timestamps were not ready by the time the record was completed.
+struct FrameRecord
+{
+  uint64_t frame;
+  // Start of the frame in seconds since the FrameTiming was created
+  double startSeconds;
+  // From the start of this frame to the start of the next
+  double frameMs;
+  float cpuMs[FRAME_STAGES];
+  float gpuMs[FRAME_STAGES];
+};
+
+// Means over the last few records
+struct FrameSummary
+{
+  size_t frames;
+  double frameMs;
+  double maxFrameMs;
+  double cpuMs[FRAME_STAGES];
+  // Over the frames whose GPU times were ready
+  double gpuMs[FRAME_STAGES];
+};
+
+// CPU time of each stage from the steady clock and GPU time from a pair of
+// GL_TIMESTAMP queries around it. The queries are read QUERY_FRAMES frames
+// after they were issued, and only if the driver says they are available, so
+// the CPU never waits for the GPU. Finished frames go into a lock-free history
+// that one other thread may read while the render thread writes. While a
+// TraceCapture runs, the GPU times are also added to it as zones on the GPU
+// track.
+//
+// Everything except the reads of the history must be on the GL thread, with
+// the context current.
+class FrameTiming
+{
+public:
+  static const size_t HISTORY = 4096;
+  static const int QUERY_FRAMES = 2;
+  // How often the GPU clock is matched to the CPU clock during a trace capture
+  static const uint64_t CALIBRATE_FRAMES = 90;
+
+  FrameTiming();
+  ~FrameTiming();
+
+  FrameTiming(const FrameTiming&) = delete;
+  FrameTiming& operator=(const FrameTiming&) = delete;
+
+  // Ends the previous frame and publishes the one QUERY_FRAMES back
+  void beginFrame(uint64_t frame);
+
+  // Each stage at most once per frame; stages do not nest
+  void beginStage(FrameStage stage);
+  void endStage(FrameStage stage);
+
+  // Waits for the GPU and publishes every frame still pending. For shutdown
+  // and dumps, not for use every frame.
+  void flush();
+
+  const SpscHistory<FrameRecord, HISTORY>& history() const { return history_; }
+
+  // Means of the last frames records (fewer if not as many were kept)
+  FrameSummary summarize(size_t frames) const;
+
+  // Every record still in the history, oldest first
+  bool writeCsv(const std::string& path) const;
+
+  // Stacked bars of the summary's CPU and GPU stage times along the bottom of
+  // the current draw framebuffer, with a tick at budgetMs. Uses scissored
+  // clears only, so it needs no shader and touches no other state.
+  static void drawOverlay(const FrameSummary& summary, int width, int height, double budgetMs);
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct PendingFrame
+  {
+    FrameRecord record;
+    bool active;
+    bool queried[FRAME_STAGES];
+  };
+
+  void publish(PendingFrame& pending, bool wait);
+  double secondsSince(Clock::time_point time) const;
+
+  SpscHistory<FrameRecord, HISTORY> history_;
+  // Begin and end timestamp of each stage, for each frame in flight
+  GLuint queries_[QUERY_FRAMES][FRAME_STAGES][2];
+  PendingFrame pending_[QUERY_FRAMES];
+  int current_;
+  Clock::time_point created_;
+  Clock::time_point frameBegin_;
+  Clock::time_point stageBegin_[FRAME_STAGES];
+};
+
+// Times the enclosing scope as one stage, and adds it to a running trace
+// capture. Only the trace zone is added without a FrameTiming.
+class FrameStageScope
+{
+public:
+  FrameStageScope(FrameTiming* timing, FrameStage stage)
+    : timing_(timing), stage_(stage), zone_(frameStageName(stage), "frame")
+  {
+    if (timing_)
+    {
+      timing_->beginStage(stage_);
+    }
+  }
+
+  ~FrameStageScope()
+  {
+    if (timing_)
+    {
+      timing_->endStage(stage_);
+    }
+  }
+
+  FrameStageScope(const FrameStageScope&) = delete;
+  FrameStageScope& operator=(const FrameStageScope&) = delete;
+
+private:
+  FrameTiming* timing_;
+  FrameStage stage_;
+  TraceZone zone_;
+};
+
+// One line for a window title or the console
+std::string formatFrameSummary(const FrameSummary& summary);
+
+#endif
@@ -0,0 +1,176 @@
+#include "GlCallCounter.h"
+
+#include <cstdio>
+
+static GlCallCounts counts = {};
+static bool installed = false;
+
+uint64_t GlCallCounts::total() const
+{
+  uint64_t sum = 0;
+  for (uint64_t c : calls)
+  {
+    sum += c;
+  }
+  return sum;
+}
+
+uint64_t GlCallCounts::draws() const
+{
+  return (*this)[GlCall::DrawArraysInstanced] + (*this)[GlCall::DrawElementsInstanced];
+}
+
+uint64_t GlCallCounts::stateChanges() const
+{
+  return total() - draws() - (*this)[GlCall::GetUniformLocation] - (*this)[GlCall::BufferData] -
+    (*this)[GlCall::BufferSubData] - (*this)[GlCall::BlitFramebuffer];
+}
+
+GlCallCounts operator+(const GlCallCounts& a, const GlCallCounts& b)
+{
+  GlCallCounts s;
+  for (int i = 0; i < static_cast<int>(GlCall::Count); i++)
+  {
+    s.calls[i] = a.calls[i] + b.calls[i];
+  }
+  return s;
+}
+
+GlCallCounts operator-(const GlCallCounts& a, const GlCallCounts& b)
+{
+  GlCallCounts d;
+  for (int i = 0; i < static_cast<int>(GlCall::Count); i++)
+  {
+    d.calls[i] = a.calls[i] - b.calls[i];
+  }
+  return d;
+}
+
+#ifndef __APPLE__
+// One instantiation per entry point, holding the driver's pointer
+template <GlCall Call, typename Ret, typename... Args>
+struct CountedCall
+{
+  static Ret (GLAPIENTRY* real)(Args...);
+
+  static Ret GLAPIENTRY call(Args... args)
+  {
+    counts.calls[static_cast<int>(Call)]++;
+    return real(args...);
+  }
+};
+
+template <GlCall Call, typename Ret, typename... Args>
+Ret (GLAPIENTRY* CountedCall<Call, Ret, Args...>::real)(Args...) = nullptr;
+
+template <GlCall Call, typename Ret, typename... Args>
+static void wrap(Ret (GLAPIENTRY*& function)(Args...))
+{
+  if (!function)
+  {
+    return;
+  }
+  CountedCall<Call, Ret, Args...>::real = function;
+  function = &CountedCall<Call, Ret, Args...>::call;
+}
+#endif
+
+void installGlCallCounter()
+{
+  if (installed)
+  {
+    return;
+  }
+#ifndef __APPLE__
+#define GL_CALL_WRAP(name) wrap<GlCall::name>(__glew##name);
+  GL_COUNTED_CALLS(GL_CALL_WRAP)
+#undef GL_CALL_WRAP
+  installed = true;
+#endif
+}
+
+bool glCallCounterInstalled()
+{
+  return installed;
+}
+
+GlCallCounts glCallCounts()
+{
+  return counts;
+}
+
+const char* glCallName(GlCall call)
+{
+  static const char* const names[] = {
+#define GL_CALL_NAME(name) "gl" #name,
+    GL_COUNTED_CALLS(GL_CALL_NAME)
+    GL_CORE_COUNTED_CALLS(GL_CALL_NAME)
+#undef GL_CALL_NAME
+  };
+  return names[static_cast<int>(call)];
+}
+
+static void countCoreCall(GlCall call)
+{
+  if (installed)
+  {
+    counts.calls[static_cast<int>(call)]++;
+  }
+}
+
+namespace glCounted
+{
+  void BindTexture(GLenum target, GLuint texture)
+  {
+    countCoreCall(GlCall::BindTexture);
+    glBindTexture(target, texture);
+  }
+
+  void Enable(GLenum cap)
+  {
+    countCoreCall(GlCall::Enable);
+    glEnable(cap);
+  }
+
+  void Disable(GLenum cap)
+  {
+    countCoreCall(GlCall::Disable);
+    glDisable(cap);
+  }
+
+  void Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+  {
+    countCoreCall(GlCall::Viewport);
+    glViewport(x, y, width, height);
+  }
+
+  void CullFace(GLenum mode)
+  {
+    countCoreCall(GlCall::CullFace);
+    glCullFace(mode);
+  }
+
+  void DepthFunc(GLenum func)
+  {
+    countCoreCall(GlCall::DepthFunc);
+    glDepthFunc(func);
+  }
+
+  void DepthMask(GLboolean flag)
+  {
+    countCoreCall(GlCall::DepthMask);
+    glDepthMask(flag);
+  }
+}
+
+void printGlCallCounts(const GlCallCounts& c, double per)
+{
+  for (int i = 0; i < static_cast<int>(GlCall::Count); i++)
+  {
+    if (c.calls[i])
+    {
+      printf("  %-24s %10.1f\n", glCallName(static_cast<GlCall>(i)), c.calls[i] / per);
+    }
+  }
+  printf("  %-24s %10.1f\n", "total", c.total() / per);
+}
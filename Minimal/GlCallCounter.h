@@ -0,0 +1,102 @@
+#ifndef GLCALLCOUNTER_H
+#define GLCALLCOUNTER_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+
+// GL entry points that can be counted. These are the ones GLEW loads at
+// runtime; GL 1.1 functions such as glDrawArrays and glBindTexture are linked
+// straight from the system library and cannot be intercepted this way.
+#define GL_COUNTED_CALLS(X) \
+  X(GetUniformLocation)     \
+  X(Uniform1i)              \
+  X(Uniform1f)              \
+  X(Uniform3fv)             \
+  X(Uniform4fv)             \
+  X(UniformMatrix4fv)       \
+  X(UseProgram)             \
+  X(BindVertexArray)        \
+  X(ActiveTexture)          \
+  X(BindBuffer)             \
+  X(BufferData)             \
+  X(BufferSubData)          \
+  X(BindBufferBase)         \
+  X(BindBufferRange)        \
+  X(VertexAttribPointer)    \
+  X(VertexAttribDivisor)    \
+  X(DrawArraysInstanced)    \
+  X(DrawElementsInstanced)  \
+  X(BindFramebuffer)        \
+  X(FramebufferTexture2D)   \
+  X(BlitFramebuffer)
+
+// The GL 1.1 state calls the render loop makes every frame. Those are only
+// counted when made through the glCounted functions below.
+#define GL_CORE_COUNTED_CALLS(X) \
+  X(BindTexture)                 \
+  X(Enable)                      \
+  X(Disable)                     \
+  X(Viewport)                    \
+  X(CullFace)                    \
+  X(DepthFunc)                   \
+  X(DepthMask)
+
+enum class GlCall
+{
+#define GL_CALL_ENUM(name) name,
+  GL_COUNTED_CALLS(GL_CALL_ENUM)
+  GL_CORE_COUNTED_CALLS(GL_CALL_ENUM)
+#undef GL_CALL_ENUM
+  Count
+};
+
+struct GlCallCounts
+{
+  uint64_t calls[static_cast<int>(GlCall::Count)];
+
+  uint64_t operator[](GlCall call) const { return calls[static_cast<int>(call)]; }
+  uint64_t total() const;
+  // The glDraw* calls
+  uint64_t draws() const;
+  // Calls that change bindings, programs, uniforms, vertex or pipeline state:
+  // everything except draws, uniform lookups, buffer uploads and blits
+  uint64_t stateChanges() const;
+};
+
+GlCallCounts operator+(const GlCallCounts& a, const GlCallCounts& b);
+GlCallCounts operator-(const GlCallCounts& a, const GlCallCounts& b);
+
+// Swaps GLEW's function pointers for wrappers that count each call before
+// forwarding it to the driver. Call once, after glewInit, on the GL thread.
+void installGlCallCounter();
+bool glCallCounterInstalled();
+
+// Running totals since installGlCallCounter
+GlCallCounts glCallCounts();
+
+const char* glCallName(GlCall call);
+
+// GL 1.1 state calls that count towards GlCallCounts once the counter is
+// installed. Use these instead of the gl* functions on the render path.
+namespace glCounted
+{
+  void BindTexture(GLenum target, GLuint texture);
+  void Enable(GLenum cap);
+  void Disable(GLenum cap);
+  void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+  void CullFace(GLenum mode);
+  void DepthFunc(GLenum func);
+  void DepthMask(GLboolean flag);
+}
+
+// One line per non-zero entry point, each divided by `per` (e.g. a frame count)
+void printGlCallCounts(const GlCallCounts& counts, double per = 1.0);
+
+#endif
@@ -0,0 +1,22 @@
+#include "HmdBackend.h"
+#include "MockHmd.h"
+#ifdef _WIN32
+#include "OvrHmd.h"
+#endif
+
+#include <stdexcept>
+
+std::unique_ptr<HmdBackend> createHmdBackend(const std::string& name, const MockHmdConfig& mockConfig)
+{
+  if (name == "mock")
+  {
+    return std::unique_ptr<HmdBackend>(new MockHmd(mockConfig));
+  }
+#ifdef _WIN32
+  if (name == "rift")
+  {
+    return std::unique_ptr<HmdBackend>(new OvrHmd());
+  }
+#endif
+  throw std::runtime_error("Unknown or unsupported HMD backend " + name);
+}
@@ -0,0 +1,79 @@
+#ifndef HMDBACKEND_H
+#define HMDBACKEND_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+
+#include <OVR_CAPI.h>
+
+#include <memory>
+#include <string>
+
+// The part of the Oculus runtime RiftApp uses, so the render loop can run
+// against something other than a headset. Types are LibOVR's, which only
+// need its headers; nothing outside OvrHmd calls into the library itself.
+//
+// Creation failures throw std::runtime_error. trackingState() may be called
+// from any thread; the texture and submit calls need the GL context current.
+class HmdBackend
+{
+public:
+  virtual ~HmdBackend() {}
+
+  virtual const char* name() const = 0;
+
+  virtual ovrHmdDesc hmdDesc() const = 0;
+  virtual ovrEyeRenderDesc renderDesc(ovrEyeType eye, const ovrFovPort& fov) = 0;
+  virtual ovrSizei fovTextureSize(ovrEyeType eye, const ovrFovPort& fov, float pixelsPerDisplayPixel) = 0;
+
+  // ovrMatrix4f_Projection with an OpenGL clip range
+  virtual ovrMatrix4f projection(const ovrFovPort& fov, float zNear, float zFar) = 0;
+  // ovr_CalcEyePoses
+  virtual void calcEyePoses(const ovrPosef& head, const ovrPosef hmdToEye[2], ovrPosef eyes[2]) = 0;
+
+  // The clock every time below is on
+  virtual double timeInSeconds() = 0;
+  virtual double predictedDisplayTime(long long frameIndex) = 0;
+  virtual ovrTrackingState trackingState(double absTime, bool latencyMarker) = 0;
+  // Touch controllers; false if they are not there
+  virtual bool inputState(ovrInputState& state) = 0;
+  virtual void recenter() = 0;
+
+  // The one color swap chain both eyes render into, sRGB RGBA8
+  virtual void createSwapChain(int width, int height) = 0;
+  virtual int swapChainLength() = 0;
+  virtual GLuint swapChainTexture(int index) = 0;
+  virtual int swapChainCurrentIndex() = 0;
+  virtual void commitSwapChain() = 0;
+
+  // What the compositor shows on the monitor, top row first
+  virtual void createMirrorTexture(int width, int height) = 0;
+  virtual GLuint mirrorTexture() = 0;
+
+  // Shows the layer, whose color texture is set to the swap chain here
+  virtual void submitFrame(long long frameIndex, const ovrViewScaleDesc& viewScale, ovrLayerEyeFov& layer) = 0;
+};
+
+// Settings of the software HMD (--hmd mock)
+struct MockHmdConfig
+{
+  // Full field of view of each eye, symmetric
+  float fovDegrees = 90.0f;
+  // Texture size of each eye
+  int eyeWidth = 1344;
+  int eyeHeight = 1600;
+  float refreshRate = 90.0f;
+  float ipdMeters = 0.064f;
+  // Keyframes for the head and hands, see MockHmd; empty for built-in motion
+  std::string motionScript;
+};
+
+// "rift" (LibOVR, Windows only) or "mock"
+std::unique_ptr<HmdBackend> createHmdBackend(const std::string& name, const MockHmdConfig& mockConfig);
+
+#endif
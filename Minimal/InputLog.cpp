@@ -0,0 +1,161 @@
+#include "InputLog.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+static const char LOG_MAGIC[4] = {'I', 'N', 'P', 'T'};
+static const uint32_t LOG_VERSION = 1;
+
+static void packPose(const ovrPoseStatef& pose, unsigned int status, InputLogPose& out)
+{
+  const ovrQuatf& q = pose.ThePose.Orientation;
+  const ovrVector3f& p = pose.ThePose.Position;
+  out.time = pose.TimeInSeconds;
+  out.orientation[0] = q.x;
+  out.orientation[1] = q.y;
+  out.orientation[2] = q.z;
+  out.orientation[3] = q.w;
+  memcpy(out.position, &p, sizeof(out.position));
+  memcpy(out.angularVelocity, &pose.AngularVelocity, sizeof(out.angularVelocity));
+  memcpy(out.linearVelocity, &pose.LinearVelocity, sizeof(out.linearVelocity));
+  memcpy(out.angularAcceleration, &pose.AngularAcceleration, sizeof(out.angularAcceleration));
+  memcpy(out.linearAcceleration, &pose.LinearAcceleration, sizeof(out.linearAcceleration));
+  out.status = status;
+}
+
+static void unpackPose(const InputLogPose& pose, ovrPoseStatef& out, unsigned int& status)
+{
+  out.TimeInSeconds = pose.time;
+  out.ThePose.Orientation.x = pose.orientation[0];
+  out.ThePose.Orientation.y = pose.orientation[1];
+  out.ThePose.Orientation.z = pose.orientation[2];
+  out.ThePose.Orientation.w = pose.orientation[3];
+  memcpy(&out.ThePose.Position, pose.position, sizeof(pose.position));
+  memcpy(&out.AngularVelocity, pose.angularVelocity, sizeof(pose.angularVelocity));
+  memcpy(&out.LinearVelocity, pose.linearVelocity, sizeof(pose.linearVelocity));
+  memcpy(&out.AngularAcceleration, pose.angularAcceleration, sizeof(pose.angularAcceleration));
+  memcpy(&out.LinearAcceleration, pose.linearAcceleration, sizeof(pose.linearAcceleration));
+  status = pose.status;
+}
+
+InputRecorder::InputRecorder(const std::string& path)
+  : path_(path), file_(fopen(path.c_str(), "wb")), frames_(0)
+{
+  if (!file_)
+  {
+    throw std::runtime_error("Unable to create input log " + path);
+  }
+  InputLogHeader header = {};
+  memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+  header.version = LOG_VERSION;
+  header.recordSize = sizeof(InputLogRecord);
+  fwrite(&header, sizeof(header), 1, file_);
+}
+
+InputRecorder::~InputRecorder()
+{
+  fclose(file_);
+  printf("Input log: %llu frames recorded to %s\n", static_cast<unsigned long long>(frames_), path_.c_str());
+}
+
+void InputRecorder::record(const FrameInput& input)
+{
+  InputLogRecord record = {};
+  record.displayTime = input.displayTime;
+  record.sensorSampleTime = input.sensorSampleTime;
+  record.frame = input.frame;
+  record.hasInput = input.hasInput ? 1 : 0;
+  if (input.hasInput)
+  {
+    const ovrInputState& in = input.input;
+    record.inputTime = in.TimeInSeconds;
+    record.controllerType = in.ControllerType;
+    record.buttons = in.Buttons;
+    record.touches = in.Touches;
+    for (int hand = 0; hand < ovrHand_Count; hand++)
+    {
+      record.indexTrigger[hand] = in.IndexTrigger[hand];
+      record.handTrigger[hand] = in.HandTrigger[hand];
+      record.thumbstick[hand][0] = in.Thumbstick[hand].x;
+      record.thumbstick[hand][1] = in.Thumbstick[hand].y;
+    }
+  }
+  packPose(input.tracking.HeadPose, input.tracking.StatusFlags, record.head);
+  for (int hand = 0; hand < ovrHand_Count; hand++)
+  {
+    packPose(input.tracking.HandPoses[hand], input.tracking.HandStatusFlags[hand], record.hands[hand]);
+  }
+  if (fwrite(&record, sizeof(record), 1, file_) == 1)
+  {
+    ++frames_;
+  }
+}
+
+InputReplay::InputReplay(const std::string& path, bool realTime)
+  : records_(nullptr), frames_(0), next_(0), realTime_(realTime)
+{
+  if (!file_.open(path))
+  {
+    throw std::runtime_error("Unable to read input log " + path);
+  }
+  const InputLogHeader* header = reinterpret_cast<const InputLogHeader*>(file_.data());
+  if (file_.size() < sizeof(InputLogHeader) || memcmp(header->magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 ||
+      header->version != LOG_VERSION || header->recordSize != sizeof(InputLogRecord))
+  {
+    throw std::runtime_error("Input log " + path + " has an unknown format");
+  }
+  records_ = reinterpret_cast<const InputLogRecord*>(header + 1);
+  // A partly written last record is dropped
+  frames_ = (file_.size() - sizeof(InputLogHeader)) / sizeof(InputLogRecord);
+  printf("Input log: replaying %zu frames from %s %s\n", frames_, path.c_str(),
+         realTime_ ? "at the recorded timing" : "as fast as possible");
+}
+
+bool InputReplay::next(FrameInput& input)
+{
+  if (next_ == frames_)
+  {
+    return false;
+  }
+  const InputLogRecord& record = records_[next_];
+  if (next_ == 0)
+  {
+    start_ = Clock::now();
+  }
+  else if (realTime_)
+  {
+    double offset = record.sensorSampleTime - records_[0].sensorSampleTime;
+    std::this_thread::sleep_until(start_ + std::chrono::duration_cast<Clock::duration>(
+                                             std::chrono::duration<double>(offset)));
+  }
+  ++next_;
+
+  input.displayTime = record.displayTime;
+  input.sensorSampleTime = record.sensorSampleTime;
+  input.hasInput = record.hasInput != 0;
+  memset(&input.input, 0, sizeof(input.input));
+  if (input.hasInput)
+  {
+    ovrInputState& in = input.input;
+    in.TimeInSeconds = record.inputTime;
+    in.ControllerType = static_cast<ovrControllerType>(record.controllerType);
+    in.Buttons = record.buttons;
+    in.Touches = record.touches;
+    for (int hand = 0; hand < ovrHand_Count; hand++)
+    {
+      in.IndexTrigger[hand] = in.IndexTriggerNoDeadzone[hand] = record.indexTrigger[hand];
+      in.HandTrigger[hand] = in.HandTriggerNoDeadzone[hand] = record.handTrigger[hand];
+      in.Thumbstick[hand].x = in.ThumbstickNoDeadzone[hand].x = record.thumbstick[hand][0];
+      in.Thumbstick[hand].y = in.ThumbstickNoDeadzone[hand].y = record.thumbstick[hand][1];
+    }
+  }
+  memset(&input.tracking, 0, sizeof(input.tracking));
+  input.tracking.CalibratedOrigin.Orientation.w = 1.0f;
+  unpackPose(record.head, input.tracking.HeadPose, input.tracking.StatusFlags);
+  for (int hand = 0; hand < ovrHand_Count; hand++)
+  {
+    unpackPose(record.hands[hand], input.tracking.HandPoses[hand], input.tracking.HandStatusFlags[hand]);
+  }
+  return true;
+}
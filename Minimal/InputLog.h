@@ -0,0 +1,138 @@
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include <OVR_CAPI.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "MappedFile.h"
+#include "PoseHistory.h"
+
+// Everything the runtime reported for one frame, sampled once at the start of
+// the frame and left untouched until the next one, so both eyes and every
+// per-frame consumer see the same poses and buttons.
+struct FrameInput
+{
+  unsigned int frame;
+  // Predicted mid-frame display time the poses are for
+  double displayTime;
+  // When the poses were sampled, for ovrLayerEyeFov::SensorSampleTime
+  double sensorSampleTime;
+  ovrTrackingState tracking;
+  ovrInputState input;
+  bool hasInput;
+
+  PoseSample poses() const
+  {
+    return makePoseSample(tracking, frame);
+  }
+};
+
+// An input log holds one fixed-size record per frame, with only the parts of
+// FrameInput the app reads, so a replay drives update and render exactly as
+// the recorded session did.
+//
+//   InputLogHeader
+//   InputLogRecord[frames]
+//
+// Records are written as the frames run, so a log cut short by a crash is
+// still good up to its last whole record.
+
+struct InputLogHeader
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t recordSize;
+  uint32_t reserved;
+};
+
+struct InputLogPose
+{
+  double time;
+  float orientation[4];
+  float position[3];
+  float angularVelocity[3];
+  float linearVelocity[3];
+  float angularAcceleration[3];
+  float linearAcceleration[3];
+  // ovrTrackingState::StatusFlags for the head, HandStatusFlags for a hand
+  uint32_t status;
+};
+
+struct InputLogRecord
+{
+  double displayTime;
+  double sensorSampleTime;
+  double inputTime;
+  uint32_t frame;
+  uint32_t hasInput;
+  uint32_t controllerType;
+  uint32_t buttons;
+  uint32_t touches;
+  float indexTrigger[ovrHand_Count];
+  float handTrigger[ovrHand_Count];
+  float thumbstick[ovrHand_Count][2];
+  uint32_t reserved;
+  InputLogPose head;
+  InputLogPose hands[ovrHand_Count];
+};
+
+// Appends a record per frame to a new log. Throws std::runtime_error if the
+// file cannot be created.
+class InputRecorder
+{
+public:
+  explicit InputRecorder(const std::string& path);
+  // Closes the log
+  ~InputRecorder();
+
+  InputRecorder(const InputRecorder&) = delete;
+  InputRecorder& operator=(const InputRecorder&) = delete;
+
+  void record(const FrameInput& input);
+
+  uint64_t frames() const { return frames_; }
+
+private:
+  std::string path_;
+  FILE* file_;
+  uint64_t frames_;
+};
+
+// Plays a log back one frame at a time, either paced like the recording (each
+// frame is held back until as much time has passed since the first one as did
+// when it was recorded) or as fast as the caller asks. Throws
+// std::runtime_error if the log is missing or malformed.
+class InputReplay
+{
+public:
+  InputReplay(const std::string& path, bool realTime);
+
+  InputReplay(const InputReplay&) = delete;
+  InputReplay& operator=(const InputReplay&) = delete;
+
+  size_t frames() const { return frames_; }
+  size_t position() const { return next_; }
+  bool finished() const { return next_ == frames_; }
+
+  // The next recorded frame, with input.frame left to the caller. False once
+  // every frame has been played.
+  bool next(FrameInput& input);
+  // Back to the first frame; the pacing starts over from there
+  void rewind() { next_ = 0; }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  MappedFile file_;
+  const InputLogRecord* records_;
+  size_t frames_;
+  size_t next_;
+  bool realTime_;
+  Clock::time_point start_;
+};
+
+#endif
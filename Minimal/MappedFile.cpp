@@ -0,0 +1,133 @@
+#include "MappedFile.h"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+#ifdef _WIN32
+  : file_(INVALID_HANDLE_VALUE), mapping_(nullptr),
+#else
+  : fd_(-1),
+#endif
+    data_(nullptr), size_(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+  close();
+
+#ifdef _WIN32
+  file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file_ == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file_, &fileSize) || fileSize.QuadPart == 0)
+  {
+    close();
+    return false;
+  }
+  mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping_)
+  {
+    close();
+    return false;
+  }
+  data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  size_ = static_cast<size_t>(fileSize.QuadPart);
+#else
+  fd_ = ::open(path.c_str(), O_RDONLY);
+  if (fd_ < 0)
+  {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0 || st.st_size == 0)
+  {
+    close();
+    return false;
+  }
+  void* ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (ptr != MAP_FAILED)
+  {
+    data_ = static_cast<const unsigned char*>(ptr);
+    size_ = static_cast<size_t>(st.st_size);
+    madvise(ptr, size_, MADV_SEQUENTIAL);
+  }
+#endif
+
+  if (!data_)
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+  if (data_)
+  {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_)
+  {
+    CloseHandle(mapping_);
+  }
+  if (file_ != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(file_);
+  }
+  file_ = INVALID_HANDLE_VALUE;
+  mapping_ = nullptr;
+#else
+  if (data_)
+  {
+    munmap(const_cast<unsigned char*>(data_), size_);
+  }
+  if (fd_ >= 0)
+  {
+    ::close(fd_);
+  }
+  fd_ = -1;
+#endif
+  data_ = nullptr;
+  size_ = 0;
+}
+
+bool statFile(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+#ifdef _WIN32
+  struct _stat64 st;
+  if (_stat64(path.c_str(), &st) != 0)
+  {
+    return false;
+  }
+#else
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+  {
+    return false;
+  }
+#endif
+  size = static_cast<uint64_t>(st.st_size);
+  mtime = static_cast<int64_t>(st.st_mtime);
+  return true;
+}
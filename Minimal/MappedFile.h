@@ -0,0 +1,41 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file. The mapping stays valid until
+// close() is called or the object is destroyed.
+class MappedFile
+{
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool open(const std::string& path);
+  void close();
+
+  bool isOpen() const { return data_ != nullptr; }
+  const unsigned char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+#ifdef _WIN32
+  void* file_;
+  void* mapping_;
+#else
+  int fd_;
+#endif
+  const unsigned char* data_;
+  size_t size_;
+};
+
+// Size and modification time of a file, used to tell whether a baked
+// artifact is older than the source it was produced from.
+bool statFile(const std::string& path, uint64_t& size, int64_t& mtime);
+
+#endif
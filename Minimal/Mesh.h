@@ -8,11 +8,16 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "shader.h"
+#include "ShaderLibrary.h"
+#include "CameraUniforms.h"
+#include "GlCallCounter.h"
+#include "VertexPacking.h"
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <utility>
 #include <vector>
 using namespace std;
 
@@ -38,63 +43,86 @@ struct Texture {
 class Mesh {
 public:
     /*  Mesh Data  */
+    // the CPU copy of what was uploaded, empty unless the mesh was asked to keep it (e.g. for picking)
     vector<Vertex> vertices;
     vector<unsigned int> indices;
     vector<Texture> textures;
     unsigned int VAO;
-	GLuint uProjection, uModelview;
+    unsigned int indexCount;
+    // the layout of the vertex buffer; the CPU copy is always Vertex
+    VertexFormat format;
 
     /*  Functions  */
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // constructor, takes over the vectors (pass them with std::move to avoid copying the mesh).
+    // the vertex and index data are freed once uploaded unless keepCpuCopy is set.
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, bool keepCpuCopy = false,
+         VertexFormat format = VertexFormat::Float)
+        : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures)),
+          indexCount(static_cast<unsigned int>(this->indices.size())), format(format),
+          uniforms(uniformNames(this->textures))
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
-
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(this->vertices.data(), this->vertices.size(), this->indices.data());
+        if(!keepCpuCopy)
+            releaseCpuCopy();
+    }
+
+    // constructor for data that lives elsewhere (e.g. a mapped bake): uploaded straight from there,
+    // and only copied if keepCpuCopy is set.
+    Mesh(const Vertex *vertexData, size_t numVertices, const unsigned int *indexData, size_t numIndices,
+         vector<Texture> textures, bool keepCpuCopy = false, VertexFormat format = VertexFormat::Float)
+        : textures(std::move(textures)), indexCount(static_cast<unsigned int>(numIndices)), format(format),
+          uniforms(uniformNames(this->textures))
+    {
+        setupMesh(vertexData, numVertices, indexData);
+        if(keepCpuCopy)
+        {
+            vertices.assign(vertexData, vertexData + numVertices);
+            indices.assign(indexData, indexData + numIndices);
+        }
+    }
+
+    // meshes own GL objects, so they are moved rather than copied
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh(Mesh&&) = default;
+    Mesh& operator=(Mesh&&) = default;
+
+    // frees the CPU copy of the vertex and index data, the GPU buffers are unaffected
+    void releaseCpuCopy()
+    {
+        vector<Vertex>().swap(vertices);
+        vector<unsigned int>().swap(indices);
     }
 
     // render the mesh
-    void Draw(GLuint shaderProgram, const glm::mat4& projection, const glm::mat4& view, glm::mat4 toWorld)
+    void Draw(ShaderProgram& shaderProgram, const glm::mat4& toWorld)
     {
+        // samplers are set on the bound program, so bind it first
+        shaderProgram.use();
+        uniforms.resolve(shaderProgram);
+
         // bind appropriate textures
-        unsigned int diffuseNr  = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr   = 1;
-        unsigned int heightNr   = 1;
         for(unsigned int i = 0; i < textures.size(); i++)
         {
             glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if(name == "texture_diffuse")
-				number = std::to_string(diffuseNr++);
-			else if(name == "texture_specular")
-				number = std::to_string(specularNr++); // transfer unsigned int to stream
-            else if(name == "texture_normal")
-				number = std::to_string(normalNr++); // transfer unsigned int to stream
-             else if(name == "texture_height")
-			    number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-													 // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shaderProgram, (name + number).c_str()), i);
+            // now set the sampler to the correct texture unit
+            glUniform1i(uniforms[U_FIRST_SAMPLER + i], i);
             // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            glCounted::BindTexture(GL_TEXTURE_2D, textures[i].id);
         }
-		glUseProgram(shaderProgram);
-		glm::mat4 modelview = view * toWorld;
-		uProjection = glGetUniformLocation(shaderProgram, "projection");
-		uModelview = glGetUniformLocation(shaderProgram, "modelview");
-		// Now send these values to the shader program
-		glUniformMatrix4fv(uProjection, 1, GL_FALSE, &projection[0][0]);
-		glUniformMatrix4fv(uModelview, 1, GL_FALSE, &modelview[0][0]);
+		// projection and view are in the Camera block, only the model matrix is per draw
+		glUniformMatrix4fv(uniforms[U_MODEL], 1, GL_FALSE, &toWorld[0][0]);
+		// packed positions are relative to the mesh's bounds
+		if(format == VertexFormat::Packed)
+		{
+			glUniform3fv(uniforms[U_POSITION_OFFSET], 1, &bounds.offset[0]);
+			glUniform3fv(uniforms[U_POSITION_SCALE], 1, &bounds.scale[0]);
+		}
         
-        // draw mesh
+        // draw mesh, once for each eye in the pass
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, CameraUniforms::eyeCount());
         glBindVertexArray(0);
 		
         // always good practice to set everything back to defaults once configured.
@@ -104,11 +132,43 @@ public:
 private:
     /*  Render data  */
     unsigned int VBO, EBO;
+    // what packed positions are relative to
+    PackedBounds bounds;
+
+    // model, the packed position bounds, then one sampler per texture
+    enum { U_MODEL, U_POSITION_OFFSET, U_POSITION_SCALE, U_FIRST_SAMPLER };
+    UniformLocations uniforms;
+
+    // sampler names follow the convention typeN, e.g. texture_diffuse1, texture_specular2
+    static vector<string> uniformNames(const vector<Texture>& textures)
+    {
+        vector<string> names = { "model", "positionOffset", "positionScale" };
+        unsigned int diffuseNr  = 1;
+        unsigned int specularNr = 1;
+        unsigned int normalNr   = 1;
+        unsigned int heightNr   = 1;
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            // retrieve texture number (the N in diffuse_textureN)
+            string number;
+            string name = textures[i].type;
+            if(name == "texture_diffuse")
+                number = std::to_string(diffuseNr++);
+            else if(name == "texture_specular")
+                number = std::to_string(specularNr++);
+            else if(name == "texture_normal")
+                number = std::to_string(normalNr++);
+            else if(name == "texture_height")
+                number = std::to_string(heightNr++);
+            names.push_back(name + number);
+        }
+        return names;
+    }
 
     /*  Functions    */
     // initializes all the buffer objects/arrays
 	
-    void setupMesh()
+    void setupMesh(const Vertex *vertexData, size_t vertexCount, const unsigned int *indexData)
     {
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
@@ -118,13 +178,22 @@ private:
         glBindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indexData, GL_STATIC_DRAW);
+
+        if(format == VertexFormat::Packed)
+        {
+            setupPackedVertices(vertexData, vertexCount);
+            glBindVertexArray(0);
+            return;
+        }
+        bounds.offset = glm::vec3(0.0f);
+        bounds.scale = glm::vec3(1.0f);
+
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertexData, GL_STATIC_DRAW);  
 
         // set the vertex attribute pointers
         // vertex Positions
@@ -145,6 +214,30 @@ private:
 
         glBindVertexArray(0);
     }
+
+    // packs the vertices into the bound vertex buffer and points the attributes at them, at the same
+    // locations as the float layout. the _packed shader variants decode them (see VertexPacking.h);
+    // there is no bitangent attribute, the shader rebuilds it.
+    void setupPackedVertices(const Vertex *vertexData, size_t vertexCount)
+    {
+        bounds = packedBounds(vertexData, vertexCount);
+        vector<PackedVertex> packed(vertexCount);
+        packVertices(vertexData, vertexCount, bounds, packed.data());
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PackedVertex), packed.data(), GL_STATIC_DRAW);
+
+        // positions across the bounds, handedness in w
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+        // octahedral normals, as plain integers
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+        // half float texture coords
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoords));
+        // octahedral tangents, as plain integers
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, tangent));
+    }
 	
 };
 #endif
\ No newline at end of file
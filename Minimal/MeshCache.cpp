@@ -0,0 +1,204 @@
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static const char CACHE_MAGIC[4] = {'M', 'E', 'S', 'H'};
+static const uint32_t CACHE_VERSION = 1;
+static const uint64_t BLOB_ALIGNMENT = 16;
+
+static uint64_t alignUp(uint64_t value)
+{
+  return (value + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+}
+
+std::string MeshCache::pathFor(const std::string& source)
+{
+  return source + ".bake";
+}
+
+MeshCache::MeshCache() : header_(nullptr), meshes_(nullptr), textures_(nullptr)
+{
+}
+
+bool MeshCache::open(const std::string& source)
+{
+  header_ = nullptr;
+  meshes_ = nullptr;
+  textures_ = nullptr;
+  std::string path = pathFor(source);
+  if (!file_.open(path))
+  {
+    return false;
+  }
+
+  const unsigned char* base = file_.data();
+  size_t size = file_.size();
+  const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(base);
+  if (size < sizeof(MeshCacheHeader) || memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+      header->version != CACHE_VERSION)
+  {
+    std::cerr << "mesh bake " << path << " has an unknown format" << std::endl;
+    file_.close();
+    return false;
+  }
+  // Baked with another Vertex layout: quietly rebuilt like a stale bake
+  if (header->vertexSize != sizeof(Vertex))
+  {
+    file_.close();
+    return false;
+  }
+
+  size_t tableSize = sizeof(MeshCacheHeader) + header->meshes * sizeof(MeshCacheMesh) +
+    header->textures * sizeof(MeshCacheTexture);
+  if (size < tableSize)
+  {
+    std::cerr << "mesh bake " << path << " is truncated" << std::endl;
+    file_.close();
+    return false;
+  }
+
+  // As with cubemap bakes the source may be left out of a shipped build, but
+  // a source that differs from the one we baked makes the bake stale
+  uint64_t sourceSize;
+  int64_t sourceTime;
+  if (statFile(source, sourceSize, sourceTime) &&
+      (sourceSize != header->sourceSize || sourceTime != header->sourceMtime))
+  {
+    file_.close();
+    return false;
+  }
+
+  const MeshCacheMesh* meshes = reinterpret_cast<const MeshCacheMesh*>(header + 1);
+  for (unsigned int i = 0; i < header->meshes; i++)
+  {
+    const MeshCacheMesh& m = meshes[i];
+    uint64_t vertexBytes = uint64_t(m.vertices) * sizeof(Vertex);
+    uint64_t indexBytes = uint64_t(m.indices) * sizeof(uint32_t);
+    if (m.vertexOffset > size || vertexBytes > size - m.vertexOffset || m.indexOffset > size ||
+        indexBytes > size - m.indexOffset || m.firstTexture > header->textures ||
+        m.textures > header->textures - m.firstTexture)
+    {
+      std::cerr << "mesh bake " << path << " is truncated" << std::endl;
+      file_.close();
+      return false;
+    }
+    // An index past the mesh's vertices would have the draw read outside its buffer
+    const uint32_t* indices = reinterpret_cast<const uint32_t*>(base + m.indexOffset);
+    if (m.vertexOffset % BLOB_ALIGNMENT != 0 || m.indexOffset % BLOB_ALIGNMENT != 0 ||
+        std::any_of(indices, indices + m.indices, [&m](uint32_t index) { return index >= m.vertices; }))
+    {
+      std::cerr << "mesh bake " << path << " has a malformed mesh" << std::endl;
+      file_.close();
+      return false;
+    }
+  }
+
+  header_ = header;
+  meshes_ = meshes;
+  textures_ = reinterpret_cast<const MeshCacheTexture*>(meshes + header->meshes);
+  return true;
+}
+
+const Vertex* MeshCache::vertices(const MeshCacheMesh& mesh) const
+{
+  return reinterpret_cast<const Vertex*>(file_.data() + mesh.vertexOffset);
+}
+
+const uint32_t* MeshCache::indices(const MeshCacheMesh& mesh) const
+{
+  return reinterpret_cast<const uint32_t*>(file_.data() + mesh.indexOffset);
+}
+
+bool bakeMeshes(const std::string& source, const std::vector<Mesh>& meshes, unsigned int optimization)
+{
+  MeshCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  header.vertexSize = sizeof(Vertex);
+  header.meshes = static_cast<uint32_t>(meshes.size());
+  header.optimization = optimization;
+  if (!statFile(source, header.sourceSize, header.sourceMtime))
+  {
+    return false;
+  }
+
+  std::vector<MeshCacheMesh> table(meshes.size());
+  std::vector<MeshCacheTexture> textures;
+  for (size_t i = 0; i < meshes.size(); i++)
+  {
+    if (meshes[i].indices.size() != meshes[i].indexCount)
+    {
+      std::cerr << "mesh bake " << MeshCache::pathFor(source) << " needs the meshes' CPU copy" << std::endl;
+      return false;
+    }
+    table[i].firstTexture = static_cast<uint32_t>(textures.size());
+    table[i].textures = static_cast<uint32_t>(meshes[i].textures.size());
+    for (const Texture& texture : meshes[i].textures)
+    {
+      MeshCacheTexture ref;
+      memset(&ref, 0, sizeof(ref));
+      if (texture.type.size() >= sizeof(ref.type) || texture.path.size() >= sizeof(ref.path))
+      {
+        std::cerr << "texture path too long for a mesh bake: " << texture.path << std::endl;
+        return false;
+      }
+      memcpy(ref.type, texture.type.data(), texture.type.size());
+      memcpy(ref.path, texture.path.data(), texture.path.size());
+      textures.push_back(ref);
+    }
+  }
+  header.textures = static_cast<uint32_t>(textures.size());
+
+  uint64_t offset = alignUp(sizeof(MeshCacheHeader) + table.size() * sizeof(MeshCacheMesh) +
+    textures.size() * sizeof(MeshCacheTexture));
+  for (size_t i = 0; i < meshes.size(); i++)
+  {
+    table[i].vertices = static_cast<uint32_t>(meshes[i].vertices.size());
+    table[i].indices = static_cast<uint32_t>(meshes[i].indices.size());
+    table[i].vertexOffset = offset;
+    offset = alignUp(offset + meshes[i].vertices.size() * sizeof(Vertex));
+    table[i].indexOffset = offset;
+    offset = alignUp(offset + meshes[i].indices.size() * sizeof(uint32_t));
+  }
+
+  std::string path = MeshCache::pathFor(source);
+  std::string tmpPath = path + ".tmp";
+  FILE* fp = fopen(tmpPath.c_str(), "wb");
+  if (!fp)
+  {
+    std::cerr << "error writing mesh bake " << tmpPath << std::endl;
+    return false;
+  }
+
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+    fwrite(table.data(), sizeof(MeshCacheMesh), table.size(), fp) == table.size() &&
+    fwrite(textures.data(), sizeof(MeshCacheTexture), textures.size(), fp) == textures.size();
+  for (size_t i = 0; i < meshes.size() && ok; i++)
+  {
+    const Mesh& mesh = meshes[i];
+    ok = fseek(fp, static_cast<long>(table[i].vertexOffset), SEEK_SET) == 0 &&
+      fwrite(mesh.vertices.data(), sizeof(Vertex), mesh.vertices.size(), fp) == mesh.vertices.size() &&
+      fseek(fp, static_cast<long>(table[i].indexOffset), SEEK_SET) == 0 &&
+      fwrite(mesh.indices.data(), sizeof(uint32_t), mesh.indices.size(), fp) == mesh.indices.size();
+  }
+  ok = (fclose(fp) == 0) && ok;
+
+  if (!ok)
+  {
+    std::cerr << "error writing mesh bake " << tmpPath << std::endl;
+    remove(tmpPath.c_str());
+    return false;
+  }
+
+  remove(path.c_str());
+  if (rename(tmpPath.c_str(), path.c_str()) != 0)
+  {
+    std::cerr << "error writing mesh bake " << path << std::endl;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,99 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Mesh.h"
+
+// A baked model is a single file next to its source (model.obj.bake) holding
+// what Model keeps from the Assimp import: every mesh's vertices, already in
+// the Vertex layout setupMesh uploads, its indices and its texture references.
+//
+//   MeshCacheHeader
+//   MeshCacheMesh[meshes]
+//   MeshCacheTexture[textures]   meshes refer to a contiguous run of these
+//   vertex and index data, every blob starting on a 16 byte boundary
+//
+// The file is memory mapped at load time, so a model loads without running
+// the importer, triangulating or generating tangents.
+
+struct MeshCacheHeader
+{
+  char magic[4];
+  uint32_t version;
+  // sizeof(Vertex) when baked; a bake from a different layout is stale
+  uint32_t vertexSize;
+  uint32_t meshes;
+  uint32_t textures;
+  // The MeshOptimization steps the meshes went through; a bake with other
+  // steps than Model applies is rebuilt
+  uint32_t optimization;
+  // The model file the bake was made from
+  uint64_t sourceSize;
+  int64_t sourceMtime;
+};
+
+struct MeshCacheMesh
+{
+  uint64_t vertexOffset;
+  uint64_t indexOffset;
+  uint32_t vertices;
+  // 32 bit indices, three per triangle
+  uint32_t indices;
+  uint32_t firstTexture;
+  uint32_t textures;
+};
+
+struct MeshCacheTexture
+{
+  // Sampler prefix, e.g. texture_diffuse
+  char type[32];
+  // As the material names it, relative to the model's directory
+  char path[224];
+};
+
+class MeshCache
+{
+public:
+  // Where the bake of the model at source lives
+  static std::string pathFor(const std::string& source);
+
+  MeshCache();
+
+  // Maps the bake of source. Fails if it is missing or malformed, or if source
+  // is still on disk and has changed since the bake was made.
+  bool open(const std::string& source);
+
+  bool isOpen() const { return header_ != nullptr; }
+  unsigned int meshCount() const { return header_->meshes; }
+  unsigned int optimization() const { return header_->optimization; }
+  const MeshCacheMesh& mesh(unsigned int i) const { return meshes_[i]; }
+  const Vertex* vertices(const MeshCacheMesh& mesh) const;
+  const uint32_t* indices(const MeshCacheMesh& mesh) const;
+  const MeshCacheTexture& texture(unsigned int i) const { return textures_[i]; }
+
+private:
+  MappedFile file_;
+  const MeshCacheHeader* header_;
+  const MeshCacheMesh* meshes_;
+  const MeshCacheTexture* textures_;
+};
+
+// Writes MeshCache::pathFor(source) from the meshes loaded from source, with
+// texture paths relative to the model's directory as Model keeps them. The
+// meshes must still have their CPU copy. optimization records the
+// MeshOptimization steps they went through.
+bool bakeMeshes(const std::string& source, const std::vector<Mesh>& meshes, unsigned int optimization = 0);
+
+#endif
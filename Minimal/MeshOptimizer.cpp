@@ -0,0 +1,314 @@
+#include "MeshOptimizer.h"
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+#include "Mesh.h"
+
+#include <algorithm>
+
+// FIFO cache by insertion time: a vertex is in the cache if it was put there
+// within the last size misses. Hits do not refresh it.
+class FifoCache
+{
+public:
+  FifoCache(size_t vertexCount, unsigned int size) : stamps_(vertexCount, 0), time_(size + 1), size_(size)
+  {
+  }
+
+  // Whether v was in the cache; if not, it is now
+  bool access(unsigned int v)
+  {
+    if (time_ - stamps_[v] <= size_)
+    {
+      return true;
+    }
+    stamps_[v] = time_++;
+    return false;
+  }
+
+  // Misses the triangle's vertices cause
+  unsigned int triangleMisses(const unsigned int* triangle)
+  {
+    return (access(triangle[0]) ? 0 : 1) + (access(triangle[1]) ? 0 : 1) + (access(triangle[2]) ? 0 : 1);
+  }
+
+  // How many misses ago v went in; more than the size once it has gone
+  size_t age(unsigned int v) const { return time_ - stamps_[v]; }
+
+  void flush() { time_ += size_ + 1; }
+
+private:
+  std::vector<size_t> stamps_;
+  size_t time_;
+  size_t size_;
+};
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount,
+                                    unsigned int cacheSize)
+{
+  VertexCacheStats stats;
+  FifoCache cache(vertexCount, cacheSize);
+  std::vector<bool> used(vertexCount, false);
+  for (size_t i = 0; i + 2 < indexCount; i += 3)
+  {
+    stats.transforms += cache.triangleMisses(indices + i);
+    ++stats.triangles;
+    for (size_t k = i; k < i + 3; k++)
+    {
+      if (!used[indices[k]])
+      {
+        used[indices[k]] = true;
+        ++stats.vertices;
+      }
+    }
+  }
+  return stats;
+}
+
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+  size_t triangleCount = indexCount / 3;
+  if (triangleCount == 0)
+  {
+    return;
+  }
+
+  // The triangles around each vertex, and how many of them are still to be emitted
+  std::vector<unsigned int> live(vertexCount, 0);
+  for (size_t i = 0; i < triangleCount * 3; i++)
+  {
+    ++live[indices[i]];
+  }
+  std::vector<size_t> offsets(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; v++)
+  {
+    offsets[v + 1] = offsets[v] + live[v];
+  }
+  std::vector<unsigned int> adjacency(triangleCount * 3);
+  std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < triangleCount * 3; i++)
+  {
+    adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+  }
+
+  FifoCache cache(vertexCount, cacheSize);
+  std::vector<bool> emitted(triangleCount, false);
+  // Vertices of emitted triangles, most recent on top, to fall back on
+  std::vector<unsigned int> deadEnd;
+  deadEnd.reserve(triangleCount * 3);
+  std::vector<unsigned int> candidates;
+  std::vector<unsigned int> result;
+  result.reserve(triangleCount * 3);
+  size_t cursor = 0;
+
+  long long fan = indices[0];
+  while (fan >= 0)
+  {
+    // Emit every triangle around the fanning vertex not emitted yet
+    candidates.clear();
+    for (size_t a = offsets[size_t(fan)]; a < offsets[size_t(fan) + 1]; a++)
+    {
+      unsigned int t = adjacency[a];
+      if (emitted[t])
+      {
+        continue;
+      }
+      emitted[t] = true;
+      for (size_t k = 0; k < 3; k++)
+      {
+        unsigned int v = indices[t * 3 + k];
+        result.push_back(v);
+        deadEnd.push_back(v);
+        candidates.push_back(v);
+        --live[v];
+        cache.access(v);
+      }
+    }
+
+    // Next, the oldest neighbour still in the cache after its own fan has put
+    // up to two new vertices per remaining triangle into it
+    fan = -1;
+    size_t bestPriority = 0;
+    for (unsigned int v : candidates)
+    {
+      if (live[v] == 0)
+      {
+        continue;
+      }
+      size_t priority = cache.age(v) + 2 * live[v] <= cacheSize ? cache.age(v) : 0;
+      if (fan < 0 || priority > bestPriority)
+      {
+        fan = v;
+        bestPriority = priority;
+      }
+    }
+
+    // A dead end: back up to a recently used vertex, or else the next one in
+    // index order with triangles left
+    while (fan < 0 && !deadEnd.empty())
+    {
+      unsigned int v = deadEnd.back();
+      deadEnd.pop_back();
+      if (live[v] > 0)
+      {
+        fan = v;
+      }
+    }
+    while (fan < 0 && cursor < vertexCount)
+    {
+      if (live[cursor] > 0)
+      {
+        fan = static_cast<long long>(cursor);
+      }
+      ++cursor;
+    }
+  }
+
+  std::copy(result.begin(), result.end(), indices);
+}
+
+void optimizeOverdraw(unsigned int* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount,
+                      float threshold)
+{
+  size_t triangleCount = indexCount / 3;
+  if (triangleCount < 2)
+  {
+    return;
+  }
+
+  // Where the cache runs cold, i.e. all three vertices miss, the order jumps
+  // anyway and a cluster may start for free
+  std::vector<size_t> hard;
+  std::vector<unsigned int> misses(triangleCount);
+  size_t totalMisses = 0;
+  FifoCache cache(vertexCount, VERTEX_CACHE_SIZE);
+  for (size_t t = 0; t < triangleCount; t++)
+  {
+    misses[t] = cache.triangleMisses(indices + t * 3);
+    totalMisses += misses[t];
+    if (t == 0 || misses[t] == 3)
+    {
+      hard.push_back(t);
+    }
+  }
+  hard.push_back(triangleCount);
+
+  // Within those, a cluster also ends once its ACMR, counted from a cold
+  // cache, is within threshold of the whole order's
+  double limit = threshold * double(totalMisses) / triangleCount;
+  std::vector<size_t> clusters;
+  for (size_t h = 0; h + 1 < hard.size(); h++)
+  {
+    size_t start = hard[h];
+    size_t clusterMisses = 0;
+    cache.flush();
+    clusters.push_back(start);
+    for (size_t t = start; t < hard[h + 1]; t++)
+    {
+      clusterMisses += cache.triangleMisses(indices + t * 3);
+      if (t + 1 < hard[h + 1] && clusterMisses <= limit * (t + 1 - start))
+      {
+        start = t + 1;
+        clusterMisses = 0;
+        cache.flush();
+        clusters.push_back(start);
+      }
+    }
+  }
+  clusters.push_back(triangleCount);
+
+  // Area weighted centroid and normal of each cluster, and of the whole mesh
+  size_t clusterCount = clusters.size() - 1;
+  std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+  std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+  glm::vec3 meshCentroid(0.0f);
+  float meshArea = 0.0f;
+  for (size_t c = 0; c < clusterCount; c++)
+  {
+    float area = 0.0f;
+    for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+    {
+      const glm::vec3& p0 = vertices[indices[t * 3]].Position;
+      const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+      const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+      glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+      float triangleArea = glm::length(normal);
+      centroids[c] += (p0 + p1 + p2) * (triangleArea / 3.0f);
+      normals[c] += normal;
+      area += triangleArea;
+    }
+    meshCentroid += centroids[c];
+    meshArea += area;
+    centroids[c] = area > 0.0f ? centroids[c] / area : glm::vec3(0.0f);
+  }
+  meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+  // Facing furthest out first
+  std::vector<float> keys(clusterCount, 0.0f);
+  for (size_t c = 0; c < clusterCount; c++)
+  {
+    float length = glm::length(normals[c]);
+    if (length > 0.0f)
+    {
+      keys[c] = glm::dot(centroids[c] - meshCentroid, normals[c] / length);
+    }
+  }
+  std::vector<size_t> order(clusterCount);
+  for (size_t c = 0; c < clusterCount; c++)
+  {
+    order[c] = c;
+  }
+  std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+  std::vector<unsigned int> result;
+  result.reserve(triangleCount * 3);
+  for (size_t c : order)
+  {
+    result.insert(result.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+  }
+  std::copy(result.begin(), result.end(), indices);
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+  const unsigned int unused = ~0u;
+  std::vector<unsigned int> remap(vertices.size(), unused);
+  std::vector<Vertex> fetched;
+  fetched.reserve(vertices.size());
+  for (unsigned int& index : indices)
+  {
+    if (remap[index] == unused)
+    {
+      remap[index] = static_cast<unsigned int>(fetched.size());
+      fetched.push_back(vertices[index]);
+    }
+    index = remap[index];
+  }
+  vertices.swap(fetched);
+}
+
+MeshOptimizationStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                                   unsigned int steps)
+{
+  MeshOptimizationStats stats;
+  stats.before = analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+  if (steps & MESH_OPTIMIZE_VERTEX_CACHE)
+  {
+    optimizeVertexCache(indices.data(), indices.size(), vertices.size());
+    if (steps & MESH_OPTIMIZE_OVERDRAW)
+    {
+      optimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertices.size());
+    }
+  }
+  if (steps & MESH_OPTIMIZE_VERTEX_FETCH)
+  {
+    optimizeVertexFetch(vertices, indices);
+  }
+  stats.after = analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+  return stats;
+}
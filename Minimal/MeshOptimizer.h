@@ -0,0 +1,76 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+struct Vertex;
+
+// The steps of optimizeMesh, combined as flags. A mesh bake records the steps
+// its meshes went through.
+enum MeshOptimization : unsigned int
+{
+  MESH_OPTIMIZE_NONE = 0,
+  // Triangles reordered for the post-transform vertex cache (Tipsify)
+  MESH_OPTIMIZE_VERTEX_CACHE = 1,
+  // Clusters of those triangles reordered to draw outward-facing ones first;
+  // needs MESH_OPTIMIZE_VERTEX_CACHE
+  MESH_OPTIMIZE_OVERDRAW = 2,
+  // Vertices renumbered in the order the triangles first use them
+  MESH_OPTIMIZE_VERTEX_FETCH = 4,
+  MESH_OPTIMIZE_DEFAULT = MESH_OPTIMIZE_VERTEX_CACHE | MESH_OPTIMIZE_VERTEX_FETCH
+};
+
+// Entries in the simulated post-transform cache. Current GPUs do not have a
+// plain FIFO of fixed size, but orders that do well on one do well on them.
+const unsigned int VERTEX_CACHE_SIZE = 16;
+
+// How often an index order runs the vertex shader, simulated with a FIFO cache
+struct VertexCacheStats
+{
+  size_t triangles = 0;
+  // Vertices the triangles refer to
+  size_t vertices = 0;
+  // Cache misses, i.e. vertex shader invocations
+  size_t transforms = 0;
+
+  // Average cache miss ratio: transforms per triangle, from 3 down to about 0.5
+  double acmr() const { return triangles ? double(transforms) / triangles : 0.0; }
+  // Average transform to vertex ratio: 1 means every vertex is shaded once
+  double atvr() const { return vertices ? double(transforms) / vertices : 0.0; }
+};
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount,
+                                    unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Reorders the triangles with Tipsify (Sander, Nehab and Barczak, "Fast
+// Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007): it
+// fans around one vertex at a time and moves on to the neighbour that is most
+// likely still in the cache. Linear in the number of triangles.
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount,
+                         unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Splits a vertex cache optimised order into clusters and sorts them so those
+// facing away from the mesh's centre, which tend to occlude the others, draw
+// first (the same paper). A cluster ends where the cache runs cold, or where
+// starting over costs no more than threshold times the order's ACMR.
+void optimizeOverdraw(unsigned int* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount,
+                      float threshold = 1.05f);
+
+// Renumbers the vertices in the order the indices first refer to them, so the
+// vertex fetch reads the buffer front to back. Vertices no triangle uses are
+// dropped.
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// The vertex cache before and after optimizeMesh
+struct MeshOptimizationStats
+{
+  VertexCacheStats before;
+  VertexCacheStats after;
+};
+
+// Runs the given MeshOptimization steps in order on a triangle list
+MeshOptimizationStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                                   unsigned int steps = MESH_OPTIMIZE_DEFAULT);
+
+#endif
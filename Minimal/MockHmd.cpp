@@ -0,0 +1,357 @@
+#include "MockHmd.h"
+
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+static const double PI = 3.14159265358979323846;
+
+static glm::quat toGlm(const ovrQuatf& q)
+{
+  return glm::quat(q.w, q.x, q.y, q.z);
+}
+
+static ovrQuatf fromGlm(const glm::quat& q)
+{
+  ovrQuatf r;
+  r.x = q.x;
+  r.y = q.y;
+  r.z = q.z;
+  r.w = q.w;
+  return r;
+}
+
+static ovrQuatf fromAngles(float yaw, float pitch, float roll)
+{
+  glm::quat q = glm::angleAxis(yaw, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::angleAxis(pitch, glm::vec3(1.0f, 0.0f, 0.0f)) *
+                glm::angleAxis(roll, glm::vec3(0.0f, 0.0f, 1.0f));
+  return fromGlm(q);
+}
+
+MockHmd::MockHmd(const MockHmdConfig& config)
+  : config_(config), start_(std::chrono::steady_clock::now()), scriptLength_(0.0), swapChainWidth_(0),
+    swapChainHeight_(0), current_(0), committed_(-1), mirror_(0), mirrorWidth_(0), mirrorHeight_(0)
+{
+  memset(swapChain_, 0, sizeof(swapChain_));
+  memset(copyFbos_, 0, sizeof(copyFbos_));
+
+  float tanHalf = static_cast<float>(std::tan(config_.fovDegrees * PI / 360.0));
+  ovrFovPort fov;
+  fov.UpTan = fov.DownTan = fov.LeftTan = fov.RightTan = tanHalf;
+
+  memset(&hmdDesc_, 0, sizeof(hmdDesc_));
+  hmdDesc_.Type = ovrHmd_Other;
+  strncpy(hmdDesc_.ProductName, "Mock HMD", sizeof(hmdDesc_.ProductName) - 1);
+  strncpy(hmdDesc_.Manufacturer, "Minimal", sizeof(hmdDesc_.Manufacturer) - 1);
+  hmdDesc_.AvailableTrackingCaps = hmdDesc_.DefaultTrackingCaps =
+    ovrTrackingCap_Orientation | ovrTrackingCap_Position;
+  for (int eye = 0; eye < ovrEye_Count; eye++)
+  {
+    hmdDesc_.DefaultEyeFov[eye] = hmdDesc_.MaxEyeFov[eye] = fov;
+  }
+  hmdDesc_.Resolution.w = 2 * config_.eyeWidth;
+  hmdDesc_.Resolution.h = config_.eyeHeight;
+  hmdDesc_.DisplayRefreshRate = config_.refreshRate;
+
+  if (!config_.motionScript.empty() && !loadScript(config_.motionScript))
+  {
+    throw std::runtime_error("Unable to read mock HMD motion script " + config_.motionScript);
+  }
+}
+
+MockHmd::~MockHmd()
+{
+  // The GL objects only exist once the app got a context to create them in; if
+  // setup failed before that, GLEW's entry points may not even be loaded
+  if (swapChainWidth_ != 0)
+  {
+    glDeleteFramebuffers(2, copyFbos_);
+    glDeleteTextures(SWAP_CHAIN_LENGTH, swapChain_);
+  }
+  if (mirror_ != 0)
+  {
+    glDeleteTextures(1, &mirror_);
+  }
+}
+
+bool MockHmd::loadScript(const std::string& path)
+{
+  FILE* file = fopen(path.c_str(), "r");
+  if (!file)
+  {
+    return false;
+  }
+  char line[256];
+  int lineNumber = 0;
+  while (fgets(line, sizeof(line), file))
+  {
+    lineNumber++;
+    char device[16];
+    Keyframe key;
+    float degrees[3];
+    if (line[strspn(line, " \t\r\n")] == '\0' || line[strspn(line, " \t")] == '#')
+    {
+      continue;
+    }
+    if (sscanf(line, "%lf %15s %f %f %f %f %f %f", &key.time, device, &key.position[0], &key.position[1],
+               &key.position[2], &degrees[0], &degrees[1], &degrees[2]) != 8)
+    {
+      printf("%s:%d: expected time device x y z yaw pitch roll\n", path.c_str(), lineNumber);
+      continue;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+      key.angles[i] = static_cast<float>(degrees[i] * PI / 180.0);
+    }
+    Device d = DeviceCount;
+    if (!strcmp(device, "head"))
+    {
+      d = Head;
+    }
+    else if (!strcmp(device, "left"))
+    {
+      d = LeftHand;
+    }
+    else if (!strcmp(device, "right"))
+    {
+      d = RightHand;
+    }
+    if (d == DeviceCount)
+    {
+      printf("%s:%d: unknown device %s\n", path.c_str(), lineNumber, device);
+      continue;
+    }
+    // Keyframes may come in any order; keep each device's sorted by time
+    std::vector<Keyframe>& keys = script_[d];
+    auto at = keys.end();
+    while (at != keys.begin() && (at - 1)->time > key.time)
+    {
+      --at;
+    }
+    keys.insert(at, key);
+    scriptLength_ = std::max(scriptLength_, key.time);
+  }
+  fclose(file);
+  return true;
+}
+
+ovrPosef MockHmd::pose(Device device, double time) const
+{
+  const std::vector<Keyframe>& keys = script_[device];
+  float position[3];
+  float angles[3];
+  if (!keys.empty())
+  {
+    double t = scriptLength_ > 0.0 ? std::fmod(time, scriptLength_) : 0.0;
+    size_t next = 0;
+    while (next < keys.size() && keys[next].time < t)
+    {
+      next++;
+    }
+    const Keyframe& b = keys[std::min(next, keys.size() - 1)];
+    const Keyframe& a = keys[next > 0 ? next - 1 : 0];
+    float f = b.time > a.time ? static_cast<float>((t - a.time) / (b.time - a.time)) : 0.0f;
+    f = std::min(1.0f, std::max(0.0f, f));
+    for (int i = 0; i < 3; i++)
+    {
+      position[i] = a.position[i] + (b.position[i] - a.position[i]) * f;
+      angles[i] = a.angles[i] + (b.angles[i] - a.angles[i]) * f;
+    }
+  }
+  else if (device == Head)
+  {
+    // A slow look around, enough to keep the view and the caches moving
+    position[0] = static_cast<float>(0.05 * std::sin(2.0 * PI * 0.13 * time));
+    position[1] = 0.0f;
+    position[2] = static_cast<float>(0.03 * std::sin(2.0 * PI * 0.07 * time));
+    angles[0] = static_cast<float>(0.35 * std::sin(2.0 * PI * 0.1 * time));
+    angles[1] = static_cast<float>(0.14 * std::sin(2.0 * PI * 0.17 * time));
+    angles[2] = 0.0f;
+  }
+  else
+  {
+    // Hands circling in front of the body, out of phase
+    double side = device == LeftHand ? -1.0 : 1.0;
+    double phase = 2.0 * PI * 0.5 * time + (device == LeftHand ? 0.0 : PI);
+    position[0] = static_cast<float>(side * 0.2 + 0.08 * std::cos(phase));
+    position[1] = static_cast<float>(-0.25 + 0.08 * std::sin(phase));
+    position[2] = -0.35f;
+    angles[0] = angles[1] = angles[2] = 0.0f;
+  }
+
+  ovrPosef pose;
+  pose.Position.x = position[0];
+  pose.Position.y = position[1];
+  pose.Position.z = position[2];
+  pose.Orientation = fromAngles(angles[0], angles[1], angles[2]);
+  return pose;
+}
+
+ovrEyeRenderDesc MockHmd::renderDesc(ovrEyeType eye, const ovrFovPort& fov)
+{
+  ovrEyeRenderDesc desc;
+  memset(&desc, 0, sizeof(desc));
+  desc.Eye = eye;
+  desc.Fov = fov;
+  desc.DistortedViewport.Pos.x = eye == ovrEye_Left ? 0 : config_.eyeWidth;
+  desc.DistortedViewport.Size.w = config_.eyeWidth;
+  desc.DistortedViewport.Size.h = config_.eyeHeight;
+  desc.PixelsPerTanAngleAtCenter.x = config_.eyeWidth / (2.0f * hmdDesc_.DefaultEyeFov[eye].LeftTan);
+  desc.PixelsPerTanAngleAtCenter.y = config_.eyeHeight / (2.0f * hmdDesc_.DefaultEyeFov[eye].UpTan);
+  desc.HmdToEyePose.Orientation.w = 1.0f;
+  desc.HmdToEyePose.Position.x = (eye == ovrEye_Left ? -0.5f : 0.5f) * config_.ipdMeters;
+  return desc;
+}
+
+ovrSizei MockHmd::fovTextureSize(ovrEyeType eye, const ovrFovPort& fov, float pixelsPerDisplayPixel)
+{
+  ovrEyeRenderDesc desc = renderDesc(eye, fov);
+  ovrSizei size;
+  size.w = static_cast<int>(std::ceil(desc.PixelsPerTanAngleAtCenter.x * (fov.LeftTan + fov.RightTan) *
+                                      pixelsPerDisplayPixel));
+  size.h = static_cast<int>(std::ceil(desc.PixelsPerTanAngleAtCenter.y * (fov.UpTan + fov.DownTan) *
+                                      pixelsPerDisplayPixel));
+  return size;
+}
+
+ovrMatrix4f MockHmd::projection(const ovrFovPort& fov, float zNear, float zFar)
+{
+  // glFrustum through the tangents, row major like ovrMatrix4f_Projection
+  ovrMatrix4f m;
+  memset(&m, 0, sizeof(m));
+  m.M[0][0] = 2.0f / (fov.LeftTan + fov.RightTan);
+  m.M[0][2] = (fov.RightTan - fov.LeftTan) / (fov.LeftTan + fov.RightTan);
+  m.M[1][1] = 2.0f / (fov.UpTan + fov.DownTan);
+  m.M[1][2] = (fov.UpTan - fov.DownTan) / (fov.UpTan + fov.DownTan);
+  m.M[2][2] = -(zFar + zNear) / (zFar - zNear);
+  m.M[2][3] = -2.0f * zFar * zNear / (zFar - zNear);
+  m.M[3][2] = -1.0f;
+  return m;
+}
+
+void MockHmd::calcEyePoses(const ovrPosef& head, const ovrPosef hmdToEye[2], ovrPosef eyes[2])
+{
+  glm::quat orientation = toGlm(head.Orientation);
+  for (int eye = 0; eye < ovrEye_Count; eye++)
+  {
+    glm::vec3 offset = orientation * glm::vec3(hmdToEye[eye].Position.x, hmdToEye[eye].Position.y,
+                                               hmdToEye[eye].Position.z);
+    eyes[eye].Orientation = fromGlm(orientation * toGlm(hmdToEye[eye].Orientation));
+    eyes[eye].Position.x = head.Position.x + offset.x;
+    eyes[eye].Position.y = head.Position.y + offset.y;
+    eyes[eye].Position.z = head.Position.z + offset.z;
+  }
+}
+
+double MockHmd::timeInSeconds()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+}
+
+double MockHmd::predictedDisplayTime(long long frameIndex)
+{
+  // Shown one refresh from now
+  return timeInSeconds() + 1.0 / config_.refreshRate;
+}
+
+ovrTrackingState MockHmd::trackingState(double absTime, bool latencyMarker)
+{
+  // 0 means now, as for the runtime
+  double time = absTime > 0.0 ? absTime : timeInSeconds();
+  const unsigned int tracked = ovrStatus_OrientationTracked | ovrStatus_PositionTracked;
+
+  ovrTrackingState state;
+  memset(&state, 0, sizeof(state));
+  state.HeadPose.ThePose = pose(Head, time);
+  state.HeadPose.TimeInSeconds = time;
+  state.StatusFlags = tracked;
+  for (int hand = 0; hand < ovrHand_Count; hand++)
+  {
+    state.HandPoses[hand].ThePose = pose(hand == ovrHand_Left ? LeftHand : RightHand, time);
+    state.HandPoses[hand].TimeInSeconds = time;
+    state.HandStatusFlags[hand] = tracked;
+  }
+  state.CalibratedOrigin.Orientation.w = 1.0f;
+  return state;
+}
+
+bool MockHmd::inputState(ovrInputState& state)
+{
+  // Controllers present, nothing pressed
+  memset(&state, 0, sizeof(state));
+  state.TimeInSeconds = timeInSeconds();
+  state.ControllerType = ovrControllerType_Touch;
+  return true;
+}
+
+void MockHmd::recenter()
+{
+  // The synthetic origin is already where the head starts
+}
+
+static GLuint createTexture(int width, int height)
+{
+  GLuint texture = 0;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return texture;
+}
+
+void MockHmd::createSwapChain(int width, int height)
+{
+  for (GLuint& texture : swapChain_)
+  {
+    texture = createTexture(width, height);
+  }
+  swapChainWidth_ = width;
+  swapChainHeight_ = height;
+  glGenFramebuffers(2, copyFbos_);
+}
+
+void MockHmd::commitSwapChain()
+{
+  committed_ = current_;
+  current_ = (current_ + 1) % SWAP_CHAIN_LENGTH;
+}
+
+void MockHmd::createMirrorTexture(int width, int height)
+{
+  mirror_ = createTexture(width, height);
+  mirrorWidth_ = width;
+  mirrorHeight_ = height;
+}
+
+void MockHmd::submitFrame(long long frameIndex, const ovrViewScaleDesc& viewScale, ovrLayerEyeFov& layer)
+{
+  layer.ColorTexture[0] = nullptr;
+  if (committed_ < 0 || !mirror_)
+  {
+    return;
+  }
+
+  // Stand-in for the compositor: the committed texture, upside down like the
+  // runtime's mirror, scaled into the mirror texture
+  GLint readFbo = 0, drawFbo = 0;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFbo);
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFbo);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, copyFbos_[0]);
+  glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, swapChain_[committed_], 0);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, copyFbos_[1]);
+  glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mirror_, 0);
+  glBlitFramebuffer(0, 0, swapChainWidth_, swapChainHeight_, 0, mirrorHeight_, mirrorWidth_, 0, GL_COLOR_BUFFER_BIT,
+                    GL_LINEAR);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, readFbo);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFbo);
+}
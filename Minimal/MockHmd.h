@@ -0,0 +1,93 @@
+#ifndef MOCKHMD_H
+#define MOCKHMD_H
+
+#include "HmdBackend.h"
+
+#include <chrono>
+#include <vector>
+
+// A software headset: fixed symmetric FOV and resolution, head and hands
+// moved by a built-in sway or a keyframe script, and swap chains made of
+// plain GL textures. Submitting a frame only copies the last committed
+// texture into the mirror texture, so the render loop runs at whatever speed
+// the GL implementation allows.
+//
+// A motion script has one keyframe per line, "#" starts a comment:
+//
+//   time device x y z yaw pitch roll
+//
+// time in seconds, device "head", "left" or "right", position in metres and
+// angles in degrees. Each device is interpolated linearly between its
+// keyframes and the whole script loops.
+class MockHmd : public HmdBackend
+{
+public:
+  static const int SWAP_CHAIN_LENGTH = 3;
+
+  explicit MockHmd(const MockHmdConfig& config);
+  ~MockHmd();
+
+  MockHmd(const MockHmd&) = delete;
+  MockHmd& operator=(const MockHmd&) = delete;
+
+  const char* name() const override { return "mock"; }
+
+  ovrHmdDesc hmdDesc() const override { return hmdDesc_; }
+  ovrEyeRenderDesc renderDesc(ovrEyeType eye, const ovrFovPort& fov) override;
+  ovrSizei fovTextureSize(ovrEyeType eye, const ovrFovPort& fov, float pixelsPerDisplayPixel) override;
+  ovrMatrix4f projection(const ovrFovPort& fov, float zNear, float zFar) override;
+  void calcEyePoses(const ovrPosef& head, const ovrPosef hmdToEye[2], ovrPosef eyes[2]) override;
+
+  double timeInSeconds() override;
+  double predictedDisplayTime(long long frameIndex) override;
+  ovrTrackingState trackingState(double absTime, bool latencyMarker) override;
+  bool inputState(ovrInputState& state) override;
+  void recenter() override;
+
+  void createSwapChain(int width, int height) override;
+  int swapChainLength() override { return SWAP_CHAIN_LENGTH; }
+  GLuint swapChainTexture(int index) override { return swapChain_[index]; }
+  int swapChainCurrentIndex() override { return current_; }
+  void commitSwapChain() override;
+
+  void createMirrorTexture(int width, int height) override;
+  GLuint mirrorTexture() override { return mirror_; }
+
+  void submitFrame(long long frameIndex, const ovrViewScaleDesc& viewScale, ovrLayerEyeFov& layer) override;
+
+private:
+  enum Device
+  {
+    Head,
+    LeftHand,
+    RightHand,
+    DeviceCount
+  };
+
+  struct Keyframe
+  {
+    double time;
+    float position[3];
+    // Yaw, pitch, roll in radians
+    float angles[3];
+  };
+
+  bool loadScript(const std::string& path);
+  ovrPosef pose(Device device, double time) const;
+
+  MockHmdConfig config_;
+  ovrHmdDesc hmdDesc_;
+  std::chrono::steady_clock::time_point start_;
+  std::vector<Keyframe> script_[DeviceCount];
+  double scriptLength_;
+
+  GLuint swapChain_[SWAP_CHAIN_LENGTH];
+  int swapChainWidth_, swapChainHeight_;
+  int current_;
+  int committed_;
+  GLuint mirror_;
+  int mirrorWidth_, mirrorHeight_;
+  GLuint copyFbos_[2];
+};
+
+#endif
@@ -5,94 +5,225 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include "Mesh.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "TextureCache.h"
+#include "WorkerPool.h"
 #include "shader.h"
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 #include <map>
 #include <vector>
 using namespace std;
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
-
 class Model 
 {
 public:
     /*  Model Data */
-    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
     vector<Mesh> meshes;
     string directory;
     bool gammaCorrection;
+    // whether the meshes keep their vertices and indices on the CPU after upload (e.g. for picking)
+    bool keepCpuCopy;
+    // the layout of the meshes' vertex buffers, which the vertex shader has to match (see vertexShader)
+    VertexFormat vertexFormat;
+    // the MeshOptimization steps an import applies to each mesh before it is uploaded and baked.
+    // MESH_OPTIMIZE_NONE keeps the triangles in the order ASSIMP produced them.
+    unsigned int meshOptimization;
+    // the vertex cache of each mesh before and after optimizeMesh; empty when the model came from its bake
+    vector<MeshOptimizationStats> optimizationStats;
 
     /*  Functions   */
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, bool keepCpuCopy = false, VertexFormat format = VertexFormat::Float,
+          unsigned int optimization = MESH_OPTIMIZE_DEFAULT)
+        : gammaCorrection(gamma), keepCpuCopy(keepCpuCopy), vertexFormat(format), meshOptimization(optimization)
     {
         loadModel(path);
     }
 
+    // hands the meshes' textures back to the cache, which frees any no other model uses
+    ~Model()
+    {
+        for(const Mesh& mesh : meshes)
+            for(const Texture& texture : mesh.textures)
+                TextureCache::instance().release(texture.id);
+    }
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    // Old behaviour for comparison: convert the meshes one after another on the loading thread
+    static void setSerialConversion(bool enabled) { serialConversion() = enabled; }
+
+    // the variant of a vertex shader that reads this model's vertex format: name.vert for float
+    // vertices, name_packed.vert for packed ones
+    string vertexShader(const string &path) const
+    {
+        if(vertexFormat != VertexFormat::Packed)
+            return path;
+        size_t extension = path.find_last_of('.');
+        return path.substr(0, extension) + "_packed" + (extension == string::npos ? "" : path.substr(extension));
+    }
+
     // draws the model, and thus all its meshes
-    void Draw(GLuint shaderProgram, const glm::mat4& projection, const glm::mat4& view, glm::mat4 toWorld)
+    // (projection and view come from the Camera uniform block)
+    void Draw(ShaderProgram& shaderProgram, const glm::mat4& toWorld)
     {
         for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shaderProgram, projection, view, toWorld);
+            meshes[i].Draw(shaderProgram, toWorld);
     }
     
 private:
+    // a mesh converted from ASSIMP's layout, before it is uploaded
+    struct MeshData
+    {
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        MeshOptimizationStats optimization;
+    };
+
+    static bool& serialConversion()
+    {
+        static bool serial = false;
+        return serial;
+    }
+
     /*  Functions   */
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
+    // an up to date bake of the file is loaded instead, and a fresh import is baked for the next time.
     void loadModel(string const &path)
     {
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // a bake optimised differently is unmapped before the import writes over it
+        unsigned int optimization = meshOptimization;
+        {
+            MeshCache cache;
+            if(cache.open(path) && cache.optimization() == optimization)
+            {
+                loadBake(cache);
+                return;
+            }
+        }
+
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        // identical vertices are joined, or every face corner would get its own and no vertex could be reused
+        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace |
+                                                       aiProcess_JoinIdenticalVertices);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
             return;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        vector<const aiMesh*> sceneMeshes;
+        processNode(scene->mRootNode, scene, sceneMeshes);
+
+        // converting and optimising the meshes needs no GL, so it runs across meshes on a pool while
+        // this thread loads the textures. only the uploads in setupMesh happen here, in scene order.
+        vector<MeshData> data(sceneMeshes.size());
+        vector<vector<Texture>> textures(sceneMeshes.size());
+        if(serialConversion() || sceneMeshes.size() < 2)
+        {
+            for(size_t i = 0; i < sceneMeshes.size(); i++)
+            {
+                convertMesh(sceneMeshes[i], data[i], optimization);
+                textures[i] = loadMaterial(scene->mMaterials[sceneMeshes[i]->mMaterialIndex]);
+            }
+        }
+        else
+        {
+            WorkerPool workers(std::min(WorkerPool::defaultThreadCount(), static_cast<unsigned int>(sceneMeshes.size())));
+            for(size_t i = 0; i < sceneMeshes.size(); i++)
+                workers.submit([&sceneMeshes, &data, i, optimization] { convertMesh(sceneMeshes[i], data[i], optimization); });
+            for(size_t i = 0; i < sceneMeshes.size(); i++)
+                textures[i] = loadMaterial(scene->mMaterials[sceneMeshes[i]->mMaterialIndex]);
+            workers.wait();
+        }
+
+        // the meshes keep their CPU copy for the bake, released below unless keepCpuCopy is set.
+        meshes.reserve(sceneMeshes.size());
+        optimizationStats.reserve(sceneMeshes.size());
+        for(size_t i = 0; i < sceneMeshes.size(); i++)
+        {
+            meshes.emplace_back(std::move(data[i].vertices), std::move(data[i].indices), std::move(textures[i]), true,
+                                vertexFormat);
+            optimizationStats.push_back(data[i].optimization);
+        }
+        if(optimization != MESH_OPTIMIZE_NONE)
+            printOptimization(path);
+
+        // the bake is written from the CPU copy, which can go once it has been
+        if(bakeMeshes(path, meshes, optimization))
+            cout << "Baked " << path << " to " << MeshCache::pathFor(path) << endl;
+        if(!keepCpuCopy)
+        {
+            for(Mesh& mesh : meshes)
+                mesh.releaseCpuCopy();
+        }
+    }
+
+    // rebuilds the meshes straight from the mapped bake, loading the textures they refer to.
+    // vertices and indices are uploaded from the mapping without a copy on the heap.
+    void loadBake(const MeshCache &cache)
+    {
+        meshes.reserve(cache.meshCount());
+        for(unsigned int i = 0; i < cache.meshCount(); i++)
+        {
+            const MeshCacheMesh& mesh = cache.mesh(i);
+            vector<Texture> textures;
+            textures.reserve(mesh.textures);
+            for(unsigned int j = 0; j < mesh.textures; j++)
+            {
+                const MeshCacheTexture& ref = cache.texture(mesh.firstTexture + j);
+                textures.push_back(loadTexture(ref.path, ref.type));
+            }
+            meshes.emplace_back(cache.vertices(mesh), mesh.vertices, cache.indices(mesh), mesh.indices,
+                                std::move(textures), keepCpuCopy, vertexFormat);
+        }
     }
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
+    // processes a node in a recursive fashion. Collects each individual mesh located at the node and repeats this process on its children nodes (if any).
+    void processNode(aiNode *node, const aiScene *scene, vector<const aiMesh*> &sceneMeshes)
     {
         // process each mesh located at the current node
         for(unsigned int i = 0; i < node->mNumMeshes; i++)
         {
             // the node object only contains indices to index the actual objects in the scene. 
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
         }
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, sceneMeshes);
         }
 
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    // converts the mesh's vertices and indices and runs the optimization steps on them. touches nothing
+    // but its arguments, so meshes convert in parallel.
+    static void convertMesh(const aiMesh *mesh, MeshData &data, unsigned int optimization)
     {
         // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
+        vector<Vertex>& vertices = data.vertices;
+        vector<unsigned int>& indices = data.indices;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(mesh->mNumFaces * 3); // triangulated
 
         // Walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -136,13 +267,43 @@ private:
         // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace& face = mesh->mFaces[i]; // by reference: a copy would allocate its own index array
             // retrieve all indices of the face and store them in the indices vector
             for(unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
         }
-        // process materials
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];    
+        data.optimization = optimizeMesh(vertices, indices, optimization);
+    }
+
+    // the vertex cache of each mesh before and after optimizeMesh, then of all of them together
+    void printOptimization(const string &path) const
+    {
+        auto printLine = [](const string &name, const VertexCacheStats &before, const VertexCacheStats &after)
+        {
+            cout << "  " << name << ": " << before.triangles << " triangles, ACMR " << before.acmr() << " -> "
+                 << after.acmr() << ", ATVR " << before.atvr() << " -> " << after.atvr() << endl;
+        };
+        cout << "Optimized " << optimizationStats.size() << " meshes of " << path << ":" << endl;
+        VertexCacheStats before, after;
+        for(size_t i = 0; i < optimizationStats.size(); i++)
+        {
+            const MeshOptimizationStats& stats = optimizationStats[i];
+            printLine("mesh " + std::to_string(i), stats.before, stats.after);
+            before.triangles += stats.before.triangles;
+            before.vertices += stats.before.vertices;
+            before.transforms += stats.before.transforms;
+            after.triangles += stats.after.triangles;
+            after.vertices += stats.after.vertices;
+            after.transforms += stats.after.transforms;
+        }
+        if(optimizationStats.size() > 1)
+            printLine("total", before, after);
+    }
+
+    // loads the mesh material's textures. needs the GL context.
+    vector<Texture> loadMaterial(aiMaterial *material)
+    {
+        vector<Texture> textures;
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
         // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER. 
         // Same applies to other texture as the following list summarizes:
@@ -162,9 +323,7 @@ private:
         // 4. height maps
         std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-        
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return textures;
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -176,69 +335,21 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
-};
-
-
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
-{
-    string filename = string(path);
-    filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
+    // gets the texture at path (relative to the model's directory) from the process-wide cache,
+    // which only loads it if no model has it yet. released again in the destructor.
+    Texture loadTexture(const char *path, const string &typeName)
     {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        Texture texture;
+        texture.id = TextureCache::instance().acquire(directory + '/' + path, gammaCorrection);
+        texture.type = typeName;
+        texture.path = path;
+        return texture;
     }
+};
 
-    return textureID;
-}
 #endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "OvrHmd.h"
+
+#include <stdexcept>
+
+OvrHmd::OvrHmd() : session_(nullptr), swapChain_(nullptr), mirror_(nullptr)
+{
+  if (!OVR_SUCCESS(ovr_Initialize(nullptr)))
+  {
+    throw std::runtime_error("Failed to initialize the Oculus SDK");
+  }
+  if (!OVR_SUCCESS(ovr_Create(&session_, &luid_)))
+  {
+    ovr_Shutdown();
+    throw std::runtime_error("Unable to create HMD session");
+  }
+  hmdDesc_ = ovr_GetHmdDesc(session_);
+}
+
+OvrHmd::~OvrHmd()
+{
+  ovr_Destroy(session_);
+  session_ = nullptr;
+  ovr_Shutdown();
+}
+
+ovrEyeRenderDesc OvrHmd::renderDesc(ovrEyeType eye, const ovrFovPort& fov)
+{
+  return ovr_GetRenderDesc(session_, eye, fov);
+}
+
+ovrSizei OvrHmd::fovTextureSize(ovrEyeType eye, const ovrFovPort& fov, float pixelsPerDisplayPixel)
+{
+  return ovr_GetFovTextureSize(session_, eye, fov, pixelsPerDisplayPixel);
+}
+
+ovrMatrix4f OvrHmd::projection(const ovrFovPort& fov, float zNear, float zFar)
+{
+  return ovrMatrix4f_Projection(fov, zNear, zFar, ovrProjection_ClipRangeOpenGL);
+}
+
+void OvrHmd::calcEyePoses(const ovrPosef& head, const ovrPosef hmdToEye[2], ovrPosef eyes[2])
+{
+  ovr_CalcEyePoses(head, hmdToEye, eyes);
+}
+
+double OvrHmd::timeInSeconds()
+{
+  return ovr_GetTimeInSeconds();
+}
+
+double OvrHmd::predictedDisplayTime(long long frameIndex)
+{
+  return ovr_GetPredictedDisplayTime(session_, frameIndex);
+}
+
+ovrTrackingState OvrHmd::trackingState(double absTime, bool latencyMarker)
+{
+  return ovr_GetTrackingState(session_, absTime, latencyMarker ? ovrTrue : ovrFalse);
+}
+
+bool OvrHmd::inputState(ovrInputState& state)
+{
+  return OVR_SUCCESS(ovr_GetInputState(session_, ovrControllerType_Touch, &state));
+}
+
+void OvrHmd::recenter()
+{
+  ovr_RecenterTrackingOrigin(session_);
+}
+
+void OvrHmd::createSwapChain(int width, int height)
+{
+  ovrTextureSwapChainDesc desc = {};
+  desc.Type = ovrTexture_2D;
+  desc.ArraySize = 1;
+  desc.Width = width;
+  desc.Height = height;
+  desc.MipLevels = 1;
+  desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
+  desc.SampleCount = 1;
+  desc.StaticImage = ovrFalse;
+  if (!OVR_SUCCESS(ovr_CreateTextureSwapChainGL(session_, &desc, &swapChain_)))
+  {
+    throw std::runtime_error("Failed to create swap textures");
+  }
+}
+
+int OvrHmd::swapChainLength()
+{
+  int length = 0;
+  if (!OVR_SUCCESS(ovr_GetTextureSwapChainLength(session_, swapChain_, &length)) || !length)
+  {
+    throw std::runtime_error("Unable to count swap chain textures");
+  }
+  return length;
+}
+
+GLuint OvrHmd::swapChainTexture(int index)
+{
+  GLuint texture = 0;
+  ovr_GetTextureSwapChainBufferGL(session_, swapChain_, index, &texture);
+  return texture;
+}
+
+int OvrHmd::swapChainCurrentIndex()
+{
+  int index = 0;
+  ovr_GetTextureSwapChainCurrentIndex(session_, swapChain_, &index);
+  return index;
+}
+
+void OvrHmd::commitSwapChain()
+{
+  ovr_CommitTextureSwapChain(session_, swapChain_);
+}
+
+void OvrHmd::createMirrorTexture(int width, int height)
+{
+  ovrMirrorTextureDesc desc = {};
+  desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
+  desc.Width = width;
+  desc.Height = height;
+  if (!OVR_SUCCESS(ovr_CreateMirrorTextureGL(session_, &desc, &mirror_)))
+  {
+    throw std::runtime_error("Could not create mirror texture");
+  }
+}
+
+GLuint OvrHmd::mirrorTexture()
+{
+  GLuint texture = 0;
+  ovr_GetMirrorTextureBufferGL(session_, mirror_, &texture);
+  return texture;
+}
+
+void OvrHmd::submitFrame(long long frameIndex, const ovrViewScaleDesc& viewScale, ovrLayerEyeFov& layer)
+{
+  layer.ColorTexture[0] = swapChain_;
+  ovrLayerHeader* headerList = &layer.Header;
+  ovr_SubmitFrame(session_, frameIndex, &viewScale, &headerList, 1);
+}
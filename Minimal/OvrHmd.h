@@ -0,0 +1,52 @@
+#ifndef OVRHMD_H
+#define OVRHMD_H
+
+#include "HmdBackend.h"
+
+#include <OVR_CAPI_GL.h>
+
+// A headset through LibOVR. Initializes the runtime for the lifetime of the
+// object, so there can only be one.
+class OvrHmd : public HmdBackend
+{
+public:
+  OvrHmd();
+  ~OvrHmd();
+
+  OvrHmd(const OvrHmd&) = delete;
+  OvrHmd& operator=(const OvrHmd&) = delete;
+
+  const char* name() const override { return "rift"; }
+
+  ovrHmdDesc hmdDesc() const override { return hmdDesc_; }
+  ovrEyeRenderDesc renderDesc(ovrEyeType eye, const ovrFovPort& fov) override;
+  ovrSizei fovTextureSize(ovrEyeType eye, const ovrFovPort& fov, float pixelsPerDisplayPixel) override;
+  ovrMatrix4f projection(const ovrFovPort& fov, float zNear, float zFar) override;
+  void calcEyePoses(const ovrPosef& head, const ovrPosef hmdToEye[2], ovrPosef eyes[2]) override;
+
+  double timeInSeconds() override;
+  double predictedDisplayTime(long long frameIndex) override;
+  ovrTrackingState trackingState(double absTime, bool latencyMarker) override;
+  bool inputState(ovrInputState& state) override;
+  void recenter() override;
+
+  void createSwapChain(int width, int height) override;
+  int swapChainLength() override;
+  GLuint swapChainTexture(int index) override;
+  int swapChainCurrentIndex() override;
+  void commitSwapChain() override;
+
+  void createMirrorTexture(int width, int height) override;
+  GLuint mirrorTexture() override;
+
+  void submitFrame(long long frameIndex, const ovrViewScaleDesc& viewScale, ovrLayerEyeFov& layer) override;
+
+private:
+  ovrSession session_;
+  ovrGraphicsLuid luid_;
+  ovrHmdDesc hmdDesc_;
+  ovrTextureSwapChain swapChain_;
+  ovrMirrorTexture mirror_;
+};
+
+#endif
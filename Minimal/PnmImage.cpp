@@ -0,0 +1,225 @@
+#include "PnmImage.h"
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <iostream>
+
+// Largest width or height accepted; well past any GL_MAX_TEXTURE_SIZE
+static const unsigned long MAX_DIMENSION = 1 << 16;
+
+static bool isSpace(unsigned char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+static bool isDigit(unsigned char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+// Reads the next unsigned decimal field, skipping whitespace and '#' comments.
+// Fails on anything that is not a digit or on values above limit.
+static bool readField(const unsigned char*& p, const unsigned char* end, unsigned long limit, unsigned long& value)
+{
+  for (;;)
+  {
+    while (p < end && isSpace(*p))
+    {
+      ++p;
+    }
+    if (p < end && *p == '#')
+    {
+      while (p < end && *p != '\n' && *p != '\r')
+      {
+        ++p;
+      }
+      continue;
+    }
+    break;
+  }
+
+  if (p == end || !isDigit(*p))
+  {
+    return false;
+  }
+  value = 0;
+  while (p < end && isDigit(*p))
+  {
+    value = value * 10 + (*p - '0');
+    if (value > limit)
+    {
+      return false;
+    }
+    ++p;
+  }
+  return p == end || isSpace(*p) || *p == '#';
+}
+
+static bool hostIsLittleEndian()
+{
+  const uint16_t one = 1;
+  return *reinterpret_cast<const unsigned char*>(&one) == 1;
+}
+
+PnmImage::PnmImage() : pixels_(nullptr), width_(0), height_(0), channels_(0), maxval_(0)
+{
+}
+
+bool PnmImage::fail(const std::string& path, const char* reason)
+{
+  std::cerr << "error parsing pnm file " << path << ": " << reason << std::endl;
+  close();
+  return false;
+}
+
+bool PnmImage::open(const std::string& path)
+{
+  close();
+  if (!file_.open(path))
+  {
+    std::cerr << "error reading pnm file, could not locate " << path << std::endl;
+    return false;
+  }
+
+  const unsigned char* p = file_.data();
+  const unsigned char* end = p + file_.size();
+  if (file_.size() < 2 || p[0] != 'P' || (p[1] != '3' && p[1] != '5' && p[1] != '6'))
+  {
+    return fail(path, "not a P3, P5 or P6 file");
+  }
+  const bool ascii = p[1] == '3';
+  const int fileChannels = p[1] == '5' ? 1 : 3;
+  // Grey is widened to RGB; uploaded as GL_RED it would sample as pure red
+  channels_ = 3;
+  p += 2;
+  if (p == end || !isSpace(*p))
+  {
+    return fail(path, "malformed magic number");
+  }
+
+  unsigned long width, height, maxval;
+  if (!readField(p, end, MAX_DIMENSION, width) || !readField(p, end, MAX_DIMENSION, height) ||
+      width == 0 || height == 0)
+  {
+    return fail(path, "invalid width or height");
+  }
+  if (!readField(p, end, 65535, maxval) || maxval == 0)
+  {
+    return fail(path, "maxval must be between 1 and 65535");
+  }
+  // Exactly one whitespace character separates the header from the raster
+  if (p == end || !isSpace(*p))
+  {
+    return fail(path, "missing pixel data");
+  }
+  ++p;
+
+  width_ = static_cast<int>(width);
+  height_ = static_cast<int>(height);
+  maxval_ = static_cast<unsigned int>(maxval);
+  const int sampleBytes = bytesPerSample();
+  // Up to 2^16 * 2^16 * 3 * 2 bytes, which does not fit a 32 bit size_t
+  if (uint64_t(width) * height * channels_ * sampleBytes > SIZE_MAX)
+  {
+    return fail(path, "image too large");
+  }
+  const size_t samples = size_t(width) * height * fileChannels;
+
+  // Checked before anything is allocated for the header's size. An ASCII
+  // sample is at least one digit, and all but the last need a separator.
+  if (!ascii && size_t(end - p) < samples * sampleBytes)
+  {
+    return fail(path, "incomplete data");
+  }
+  if (ascii && size_t(end - p) < samples * 2 - 1)
+  {
+    return fail(path, "incomplete data");
+  }
+
+  if (!ascii && fileChannels == 3 && (maxval_ == 255 || maxval_ == 65535))
+  {
+    pixels_ = p;
+    return true;
+  }
+
+  // Everything else is decoded into full range RGB samples in host byte order
+  const size_t copies = channels_ / fileChannels;
+  decoded_.resize(samples * copies * sampleBytes);
+  const unsigned int fullRange = sampleBytes == 2 ? 65535 : 255;
+  for (size_t i = 0; i < samples; i++)
+  {
+    unsigned long value;
+    if (ascii)
+    {
+      if (!readField(p, end, maxval_, value))
+      {
+        return fail(path, "invalid or missing sample");
+      }
+    }
+    else
+    {
+      value = sampleBytes == 2 ? (unsigned long)(p[2 * i] << 8 | p[2 * i + 1]) : p[i];
+      if (value > maxval_)
+      {
+        return fail(path, "sample larger than maxval");
+      }
+    }
+
+    unsigned long scaled = (value * fullRange + maxval_ / 2) / maxval_;
+    for (size_t c = i * copies; c < (i + 1) * copies; c++)
+    {
+      if (sampleBytes == 2)
+      {
+        reinterpret_cast<uint16_t*>(decoded_.data())[c] = static_cast<uint16_t>(scaled);
+      }
+      else
+      {
+        decoded_[c] = static_cast<unsigned char>(scaled);
+      }
+    }
+  }
+  pixels_ = decoded_.data();
+  return true;
+}
+
+void PnmImage::close()
+{
+  file_.close();
+  decoded_.clear();
+  decoded_.shrink_to_fit();
+  pixels_ = nullptr;
+  width_ = height_ = channels_ = 0;
+  maxval_ = 0;
+}
+
+unsigned int PnmImage::glInternalFormat() const
+{
+  return bytesPerSample() == 2 ? GL_RGB16 : GL_RGB8;
+}
+
+unsigned int PnmImage::glFormat() const
+{
+  return GL_RGB;
+}
+
+unsigned int PnmImage::glType() const
+{
+  return bytesPerSample() == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+}
+
+bool PnmImage::swapBytes() const
+{
+  return isMapped() && bytesPerSample() == 2 && hostIsLittleEndian();
+}
+
+void PnmImage::upload(unsigned int target, int level) const
+{
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  if (swapBytes())
+  {
+    glPixelStorei(GL_UNPACK_SWAP_BYTES, GL_TRUE);
+  }
+  glTexImage2D(target, level, glInternalFormat(), width_, height_, 0, glFormat(), glType(), pixels_);
+  glPixelStorei(GL_UNPACK_SWAP_BYTES, GL_FALSE);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
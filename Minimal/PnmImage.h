@@ -0,0 +1,63 @@
+#ifndef PNMIMAGE_H
+#define PNMIMAGE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+// A PPM/PGM image read straight out of a memory mapped file. Binary RGB
+// images (P6) with a maxval of 255 or 65535 are not copied at all: pixels()
+// points into the mapping and can be passed to glTexImage2D as is. ASCII
+// images (P3) and binary images with any other maxval are decoded or rescaled
+// into an owned buffer, since the GPU cannot consume them directly. So are
+// grey images (P5), which are widened to RGB: every image has three channels.
+//
+// The header is validated strictly; anything that is not a well formed
+// P3/P5/P6 file with 1 <= maxval <= 65535 and enough pixel data is rejected.
+class PnmImage
+{
+public:
+  PnmImage();
+
+  PnmImage(const PnmImage&) = delete;
+  PnmImage& operator=(const PnmImage&) = delete;
+
+  bool open(const std::string& path);
+  void close();
+
+  bool isOpen() const { return pixels_ != nullptr; }
+  int width() const { return width_; }
+  int height() const { return height_; }
+  int channels() const { return channels_; }
+  unsigned int maxval() const { return maxval_; }
+  int bytesPerSample() const { return maxval_ > 255 ? 2 : 1; }
+  bool isMapped() const { return decoded_.empty(); }
+
+  const unsigned char* pixels() const { return pixels_; }
+  size_t size() const { return size_t(width_) * height_ * channels_ * bytesPerSample(); }
+
+  // Upload description for glTexImage2D. 16 bit PNM samples are big endian,
+  // so swapBytes() says whether GL_UNPACK_SWAP_BYTES must be set for them.
+  unsigned int glInternalFormat() const;
+  unsigned int glFormat() const;
+  unsigned int glType() const;
+  bool swapBytes() const;
+
+  // glTexImage2D(target, level, ...) from pixels(), with the unpack state set up
+  void upload(unsigned int target, int level) const;
+
+private:
+  bool fail(const std::string& path, const char* reason);
+
+  MappedFile file_;
+  std::vector<unsigned char> decoded_;
+  const unsigned char* pixels_;
+  int width_;
+  int height_;
+  int channels_;
+  unsigned int maxval_;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "PoseHistory.h"
+
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+PoseSample makePoseSample(const ovrTrackingState& tracking, uint64_t frame)
+{
+  PoseSample sample;
+  sample.time = tracking.HeadPose.TimeInSeconds;
+  sample.frame = frame;
+  sample.head = tracking.HeadPose;
+  for (int hand = 0; hand < ovrHand_Count; hand++)
+  {
+    sample.hands[hand] = tracking.HandPoses[hand];
+    sample.handStatus[hand] = tracking.HandStatusFlags[hand];
+  }
+  return sample;
+}
+
+static ovrVector3f lerp(const ovrVector3f& a, const ovrVector3f& b, float t)
+{
+  ovrVector3f v;
+  v.x = a.x + (b.x - a.x) * t;
+  v.y = a.y + (b.y - a.y) * t;
+  v.z = a.z + (b.z - a.z) * t;
+  return v;
+}
+
+static ovrQuatf slerp(const ovrQuatf& a, const ovrQuatf& b, float t)
+{
+  // glm::quat takes w first; slerp takes the short way round
+  glm::quat q = glm::slerp(glm::quat(a.w, a.x, a.y, a.z), glm::quat(b.w, b.x, b.y, b.z), t);
+  ovrQuatf r;
+  r.x = q.x;
+  r.y = q.y;
+  r.z = q.z;
+  r.w = q.w;
+  return r;
+}
+
+static ovrPoseStatef interpolate(const ovrPoseStatef& a, const ovrPoseStatef& b, float t, double time)
+{
+  ovrPoseStatef p;
+  p.ThePose.Orientation = slerp(a.ThePose.Orientation, b.ThePose.Orientation, t);
+  p.ThePose.Position = lerp(a.ThePose.Position, b.ThePose.Position, t);
+  p.AngularVelocity = lerp(a.AngularVelocity, b.AngularVelocity, t);
+  p.LinearVelocity = lerp(a.LinearVelocity, b.LinearVelocity, t);
+  p.AngularAcceleration = lerp(a.AngularAcceleration, b.AngularAcceleration, t);
+  p.LinearAcceleration = lerp(a.LinearAcceleration, b.LinearAcceleration, t);
+  p.TimeInSeconds = time;
+  return p;
+}
+
+PoseSample interpolate(const PoseSample& a, const PoseSample& b, double time)
+{
+  double span = b.time - a.time;
+  float t = span > 0.0 ? static_cast<float>((time - a.time) / span) : 1.0f;
+  t = glm::clamp(t, 0.0f, 1.0f);
+
+  PoseSample s = t < 0.5f ? a : b;
+  s.time = time;
+  s.head = interpolate(a.head, b.head, t, time);
+  for (int hand = 0; hand < ovrHand_Count; hand++)
+  {
+    s.hands[hand] = interpolate(a.hands[hand], b.hands[hand], t, time);
+  }
+  return s;
+}
@@ -0,0 +1,131 @@
+#ifndef POSEHISTORY_H
+#define POSEHISTORY_H
+
+#include <OVR_CAPI.h>
+
+#include "SpscHistory.h"
+
+// Head and hand poses, with their velocities, at one point in time
+struct PoseSample
+{
+  // HmdBackend::timeInSeconds time the poses are for
+  double time;
+  // Render frame that sampled them
+  uint64_t frame;
+  ovrPoseStatef head;
+  ovrPoseStatef hands[ovrHand_Count];
+  unsigned int handStatus[ovrHand_Count];
+};
+
+// The head and hand poses of a tracking state; time is the head pose's
+PoseSample makePoseSample(const ovrTrackingState& tracking, uint64_t frame);
+
+// The poses at time, which should lie between a.time and b.time: positions and
+// velocities are interpolated linearly, orientations with slerp. Status flags
+// come from whichever sample is nearer.
+PoseSample interpolate(const PoseSample& a, const PoseSample& b, double time);
+
+// Recent PoseSamples, pushed by one thread (the render loop or a tracking
+// thread) and looked up by another, by age in samples or by time.
+template <size_t Capacity>
+class PoseHistory
+{
+public:
+  // One entry stays free for the sample being pushed, so lookups can reach
+  // this many samples back
+  static const size_t MAX_OFFSET = Capacity - 2;
+
+  // Producer only. Sample times must not decrease.
+  void push(const PoseSample& sample)
+  {
+    samples_.push(sample);
+  }
+
+  bool empty() const
+  {
+    return samples_.count() == 0;
+  }
+
+  // The sample pushed offset samples before the newest (0 is the newest), or
+  // the oldest one still held if there are not that many. With one push per
+  // frame the offset is in frames. False only when nothing has been pushed.
+  bool atOffset(size_t offset, PoseSample& sample) const
+  {
+    for (;;)
+    {
+      uint64_t count = samples_.count();
+      if (count == 0)
+      {
+        return false;
+      }
+      uint64_t held = count < MAX_OFFSET + 1 ? count : MAX_OFFSET + 1;
+      uint64_t back = offset < held ? offset : held - 1;
+      if (samples_.read(count - 1 - back, sample))
+      {
+        return true;
+      }
+      // The producer lapped the entry while it was read; the next one is newer
+    }
+  }
+
+  // The poses at time, interpolated between the samples either side of it.
+  // Times before the oldest or after the newest sample get that sample. False
+  // only when nothing has been pushed.
+  bool atTime(double time, PoseSample& sample) const
+  {
+    for (;;)
+    {
+      uint64_t count = samples_.count();
+      if (count == 0)
+      {
+        return false;
+      }
+      PoseSample newest;
+      if (!samples_.read(count - 1, newest))
+      {
+        continue;
+      }
+      if (time >= newest.time)
+      {
+        sample = newest;
+        return true;
+      }
+
+      // Binary search for the first sample newer than time. Entries the
+      // producer overwrote during the search count as too old.
+      uint64_t oldest = count > MAX_OFFSET + 1 ? count - (MAX_OFFSET + 1) : 0;
+      uint64_t low = oldest, high = count - 1;
+      while (low < high)
+      {
+        uint64_t middle = low + (high - low) / 2;
+        PoseSample probe;
+        if (!samples_.read(middle, probe) || probe.time <= time)
+        {
+          low = middle + 1;
+        }
+        else
+        {
+          high = middle;
+        }
+      }
+      PoseSample before, after;
+      if (!samples_.read(high, after))
+      {
+        continue;
+      }
+      if (high == oldest || !samples_.read(high - 1, before))
+      {
+        // Older than everything still held
+        sample = after;
+        return true;
+      }
+      sample = interpolate(before, after, time);
+      return true;
+    }
+  }
+
+private:
+  SpscHistory<PoseSample, Capacity> samples_;
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include "Scene.h"
+#include "CubemapLoader.h"
+#include "Skybox.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+
+// ovrEye_Left and ovrEye_Right, without pulling in LibOVR
+static const int LEFT_EYE = 0;
+static const int RIGHT_EYE = 1;
+
+Scene::Scene(bool serial, unsigned int gridSize) : GRID_SIZE(gridSize)
+{
+  if (GRID_SIZE == 0)
+  {
+    // Create two cube
+    instance_positions.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, -0.3)));
+    instance_positions.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, -0.9)));
+  }
+  else
+  {
+    // GRID_SIZE^3 cubes, centred left/right and up/down, starting 30cm in front of the origin
+    float half = (GRID_SIZE - 1) * GRID_SPACING * 0.5f;
+    instance_positions.reserve(GRID_SIZE * GRID_SIZE * GRID_SIZE);
+    for (unsigned int z = 0; z < GRID_SIZE; z++)
+      for (unsigned int y = 0; y < GRID_SIZE; y++)
+        for (unsigned int x = 0; x < GRID_SIZE; x++)
+        {
+          glm::vec3 position(x * GRID_SPACING - half, y * GRID_SPACING - half, -0.3f - z * GRID_SPACING);
+          instance_positions.push_back(glm::translate(glm::mat4(1.0f), position));
+        }
+  }
+
+  instanceCount = instance_positions.size();
+
+  // Shader Program
+  cubeShader = &ShaderLibrary::instance().load("texturedcube.vert", "skybox.frag");
+  instancedCubeShader = &ShaderLibrary::instance().load("texturedcube_instanced.vert", "skybox.frag");
+  skyboxShader = &ShaderLibrary::instance().load("skybox.vert", "skybox.frag");
+
+  if (serial)
+  {
+    cube = std::make_unique<TexturedCube>("cube");
+    skybox_left = std::make_unique<Skybox>("skybox_left");
+    skybox_right = std::make_unique<Skybox>("skybox_right");
+    skybox_custom = std::make_unique<Skybox>("skybox_custom");
+  }
+  else
+  {
+    loader = std::make_unique<CubemapLoader>();
+    cube = std::make_unique<TexturedCube>("cube", *loader);
+    skybox_left = std::make_unique<Skybox>("skybox_left", *loader);
+    skybox_right = std::make_unique<Skybox>("skybox_right", *loader);
+    skybox_custom = std::make_unique<Skybox>("skybox_custom", *loader);
+  }
+
+	  // 10m wide sky box: size doesn't matter though
+	skybox_left ->toWorld = glm::scale(glm::mat4(1.0f), glm::vec3(5.0f));
+	skybox_right->toWorld = glm::scale(glm::mat4(1.0f), glm::vec3(5.0f));
+
+	cubeSize = glm::scale(glm::mat4(1.0f), glm::vec3(0.1f));
+
+	skybox_custom->toWorld = glm::scale(glm::mat4(1.0f), glm::vec3(5.0f));
+}
+
+// Here, where the cubemap classes are complete
+Scene::~Scene()
+{
+}
+
+void Scene::pumpUploads()
+{
+  if (loader && !loader->idle())
+  {
+    loader->pump(UPLOAD_BUDGET);
+  }
+}
+
+bool Scene::resident() const
+{
+  return !loader || loader->idle();
+}
+
+unsigned int Scene::setSkyboxSize(unsigned int size)
+{
+  unsigned int sampled = 0;
+  for (Skybox* skybox : { skybox_left.get(), skybox_right.get(), skybox_custom.get() })
+  {
+    sampled = std::max(sampled, skybox->setMaxSize(size));
+  }
+  return sampled;
+}
+
+void Scene::stepCubeSize()
+{
+	  if (sizeStep == 2 && cubeSize[0][0] > 0.01f) {
+		  cubeSize = cubeSize * glm::scale(glm::mat4(1.0f), glm::vec3(0.99f));
+		  instancesDirty = true;
+	  }
+
+	  if (sizeStep == 3 && cubeSize[0][0] < 0.5f) {
+		  cubeSize = cubeSize * glm::scale(glm::mat4(1.0f), glm::vec3(1.01f));
+		  instancesDirty = true;
+	  }
+
+	  if (sizeStep == 4) {
+		  cubeSize = glm::scale(glm::mat4(1.0f), glm::vec3(0.1f));
+		  instancesDirty = true;
+	  }
+}
+
+void Scene::render(int eye)
+{
+	  // The size steps once per eye rendered, so it changes at the same rate in both modes
+	  stepCubeSize();
+	  if (eye == BOTH_EYES) {
+		  stepCubeSize();
+	  }
+    // Render the cubes
+	if (view == 1) {
+		if (instancing) {
+			if (instancesDirty) {
+				std::vector<glm::mat4> models(instanceCount);
+				for (GLuint i = 0; i < instanceCount; i++) {
+					// Scale to 20cm: 200cm * 0.1
+					models[i] = instance_positions[i] * cubeSize;
+				}
+				cube->toWorld = glm::mat4(1.0f);
+				cube->setInstances(models);
+				instancesDirty = false;
+			}
+			cube->drawInstanced(*instancedCubeShader);
+		}
+		else {
+			for (int i = 0; i < instanceCount; i++)
+				{
+				  // Scale to 20cm: 200cm * 0.1
+				  cube->toWorld = instance_positions[i] * cubeSize;
+				  cube->draw(*cubeShader);
+				}
+		}
+	}
+
+	if (view == 1 || view == 2) {
+		// Render Skybox : remove view translation
+			if (eye == BOTH_EYES) {
+				// Each eye has its own sky, so these are one draw per eye
+				skybox_left->draw(*skyboxShader, LEFT_EYE);
+				skybox_right->draw(*skyboxShader, RIGHT_EYE);
+			}
+			else if (eye == LEFT_EYE) {
+				skybox_left->draw(*skyboxShader);
+			}
+			else {
+				skybox_right->draw(*skyboxShader);
+			}
+	}
+
+	else if (view == 3) {
+		skybox_left->draw(*skyboxShader);
+	}
+
+	else if (view == 4) {
+		skybox_custom->draw(*skyboxShader);
+	}
+}
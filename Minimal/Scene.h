@@ -0,0 +1,92 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "ShaderLibrary.h"
+
+class CubemapLoader;
+class Skybox;
+class TexturedCube;
+
+// The cubes and the skyboxes around them. The camera comes from the Camera
+// uniform block, so the same Scene renders for the app and the benchmarks.
+class Scene
+{
+public:
+  // Draws into both eyes of a single-pass stereo camera
+  static const int BOTH_EYES = -1;
+
+  // gridSize cubes per side, 0 for the original pair. serial loads every
+  // cubemap before returning, otherwise they load in the background and
+  // pumpUploads must be called once a frame.
+  Scene(bool serial, unsigned int gridSize);
+  ~Scene();
+
+  // What render draws (the X button): 1 cubes and the per-eye skyboxes,
+  // 2 the skyboxes only, 3 the left skybox in both eyes, 4 the custom skybox
+  int view{1};
+  // How the cube size changes for each eye rendered (the left thumbstick):
+  // 1 not at all, 2 shrinks, 3 grows, 4 goes back to 20cm
+  int sizeStep{1};
+  // One instanced draw for all cubes instead of a draw per cube
+  bool instancing{true};
+
+  // Upload the next part of any cubemaps still loading in the background
+  void pumpUploads();
+  bool resident() const;
+
+  unsigned int cubeCount() const { return instanceCount; }
+
+  // Samples the skyboxes from the first mip level no larger than size, as if
+  // they had been loaded at that resolution. Without a baked mip chain only
+  // the full size is there. Returns the face size now sampled.
+  unsigned int setSkyboxSize(unsigned int size);
+
+  // The camera must already be in the Camera uniform block. eye is ovrEye_Left,
+  // ovrEye_Right or BOTH_EYES.
+  void render(int eye);
+
+private:
+  //Change the size of cubes
+  void stepCubeSize();
+
+  // Program
+  std::vector<glm::mat4> instance_positions;
+  GLuint instanceCount;
+  ShaderProgram* cubeShader;
+  ShaderProgram* instancedCubeShader;
+  ShaderProgram* skyboxShader;
+
+  std::unique_ptr<CubemapLoader> loader;
+  std::unique_ptr<TexturedCube> cube;
+  std::unique_ptr<Skybox> skybox_left;
+  std::unique_ptr<Skybox> skybox_right;
+  std::unique_ptr<Skybox> skybox_custom;
+
+  const unsigned int GRID_SIZE;
+  // Distance between neighbouring grid cubes, in metres
+  const float GRID_SPACING{0.3f};
+
+  // Bytes of cubemap data uploaded per frame while loading in the background
+  const size_t UPLOAD_BUDGET{16 * 1024 * 1024};
+
+  glm::mat4 cubeSize;
+  // The instance buffer holds instance_positions * cubeSize and is refreshed when cubeSize changes
+  bool instancesDirty{true};
+};
+
+#endif
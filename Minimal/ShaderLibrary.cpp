@@ -0,0 +1,210 @@
+#include "ShaderLibrary.h"
+#include "shader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+ShaderProgram::ShaderProgram(GLuint id, const std::string& name, double buildMs)
+  : id_(id), name_(name), buildMs_(buildMs), useCount_(0), requests_(0)
+{
+  if (id_)
+  {
+    reflect();
+  }
+}
+
+ShaderProgram::~ShaderProgram()
+{
+  glDeleteProgram(id_);
+}
+
+void ShaderProgram::use()
+{
+  glUseProgram(id_);
+  ++useCount_;
+}
+
+static GLint findLocation(const std::unordered_map<std::string, ShaderProgram::Variable>& variables,
+                          const std::string& name)
+{
+  auto it = variables.find(name);
+  return it == variables.end() ? -1 : it->second.location;
+}
+
+GLint ShaderProgram::uniform(const std::string& name) const
+{
+  return findLocation(uniforms_, name);
+}
+
+GLint ShaderProgram::attribute(const std::string& name) const
+{
+  return findLocation(attributes_, name);
+}
+
+// Drivers report arrays as "name[0]"; also file them under the bare name
+static void addVariable(std::unordered_map<std::string, ShaderProgram::Variable>& variables,
+                        const std::string& name, const ShaderProgram::Variable& variable)
+{
+  variables[name] = variable;
+  const std::string suffix = "[0]";
+  if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+  {
+    variables[name.substr(0, name.size() - suffix.size())] = variable;
+  }
+}
+
+void ShaderProgram::reflect()
+{
+  GLint linked = GL_FALSE;
+  glGetProgramiv(id_, GL_LINK_STATUS, &linked);
+  if (linked != GL_TRUE)
+  {
+    return;
+  }
+
+  GLint count = 0, maxLength = 0;
+  glGetProgramiv(id_, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(id_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  std::vector<GLchar> buffer(std::max(maxLength, 1));
+  for (GLint i = 0; i < count; i++)
+  {
+    GLsizei length = 0;
+    Variable v;
+    glGetActiveUniform(id_, i, maxLength, &length, &v.size, &v.type, buffer.data());
+    std::string name(buffer.data(), length);
+    // -1 for members of uniform blocks, which are not set through locations
+    v.location = glGetUniformLocation(id_, name.c_str());
+    addVariable(uniforms_, name, v);
+  }
+
+  glGetProgramiv(id_, GL_ACTIVE_ATTRIBUTES, &count);
+  glGetProgramiv(id_, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+  buffer.resize(std::max(maxLength, 1));
+  for (GLint i = 0; i < count; i++)
+  {
+    GLsizei length = 0;
+    Variable v;
+    glGetActiveAttrib(id_, i, maxLength, &length, &v.size, &v.type, buffer.data());
+    std::string name(buffer.data(), length);
+    v.location = glGetAttribLocation(id_, name.c_str());
+    addVariable(attributes_, name, v);
+  }
+}
+
+static bool lookupEveryDraw = false;
+
+UniformLocations::UniformLocations(std::vector<std::string> names)
+  : names_(std::move(names)), locations_(names_.size(), -1), program_(0)
+{
+}
+
+void UniformLocations::resolve(const ShaderProgram& program)
+{
+  if (lookupEveryDraw)
+  {
+    for (size_t i = 0; i < names_.size(); i++)
+    {
+      locations_[i] = glGetUniformLocation(program.id(), names_[i].c_str());
+    }
+    program_ = 0;
+    return;
+  }
+  if (program.id() == program_)
+  {
+    return;
+  }
+  for (size_t i = 0; i < names_.size(); i++)
+  {
+    locations_[i] = program.uniform(names_[i]);
+  }
+  program_ = program.id();
+}
+
+void UniformLocations::setLookupEveryDraw(bool enabled)
+{
+  lookupEveryDraw = enabled;
+}
+
+ShaderLibrary& ShaderLibrary::instance()
+{
+  static ShaderLibrary library;
+  return library;
+}
+
+ShaderProgram& ShaderLibrary::load(const std::string& vertexPath, const std::string& fragmentPath)
+{
+  std::string name = vertexPath + " + " + fragmentPath;
+  std::string vertexCode, fragmentCode;
+  uint64_t key;
+  bool readable = readShaderSources(vertexPath.c_str(), fragmentPath.c_str(), vertexCode, fragmentCode);
+  if (readable)
+  {
+    key = hashShaderSources(vertexCode, fragmentCode);
+  }
+  else
+  {
+    // Nothing to hash; key the empty program on the paths instead
+    key = hashShaderSources(vertexPath, fragmentPath) ^ 1;
+  }
+
+  std::unique_ptr<ShaderProgram>& program = programs_[key];
+  if (!program)
+  {
+    auto start = std::chrono::steady_clock::now();
+    GLuint id = readable ? LoadShadersFromSource(vertexCode, fragmentCode, vertexPath.c_str(), fragmentPath.c_str()) : 0;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    program.reset(new ShaderProgram(id, name, ms));
+    applyUniformBlocks(*program);
+  }
+  else if (program->name() != name)
+  {
+    printf("Program %s shares its sources with %s\n", name.c_str(), program->name().c_str());
+  }
+  program->requests_++;
+  return *program;
+}
+
+void ShaderLibrary::bindUniformBlock(const std::string& name, GLuint binding)
+{
+  uniformBlocks_[name] = binding;
+  for (const auto& entry : programs_)
+  {
+    applyUniformBlocks(*entry.second);
+  }
+}
+
+void ShaderLibrary::applyUniformBlocks(const ShaderProgram& program) const
+{
+  if (!program.id())
+  {
+    return;
+  }
+  for (const auto& block : uniformBlocks_)
+  {
+    GLuint index = glGetUniformBlockIndex(program.id(), block.first.c_str());
+    if (index != GL_INVALID_INDEX)
+    {
+      glUniformBlockBinding(program.id(), index, block.second);
+    }
+  }
+}
+
+void ShaderLibrary::printStats() const
+{
+  printf("Shader library: %u programs\n", static_cast<unsigned int>(programs_.size()));
+  for (const auto& entry : programs_)
+  {
+    const ShaderProgram& p = *entry.second;
+    printf("  %-48s build %7.2f ms  uses %10llu  shared by %u  uniforms %u  attributes %u\n", p.name().c_str(),
+           p.buildMs(), static_cast<unsigned long long>(p.useCount()), p.requests(),
+           static_cast<unsigned int>(p.uniforms().size()), static_cast<unsigned int>(p.attributes().size()));
+  }
+}
+
+void ShaderLibrary::clear()
+{
+  programs_.clear();
+}
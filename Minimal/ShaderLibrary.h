@@ -0,0 +1,128 @@
+#ifndef SHADERLIBRARY_H
+#define SHADERLIBRARY_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A linked program plus what the driver reported about it at link time.
+// Instances are owned by the ShaderLibrary and shared by everything that
+// asked for the same pair of sources.
+class ShaderProgram
+{
+public:
+  struct Variable
+  {
+    GLint location;
+    GLenum type;
+    GLint size;
+  };
+
+  ShaderProgram(GLuint id, const std::string& name, double buildMs);
+  ~ShaderProgram();
+
+  ShaderProgram(const ShaderProgram&) = delete;
+  ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+  GLuint id() const { return id_; }
+  const std::string& name() const { return name_; }
+
+  // glUseProgram, counted for the stats
+  void use();
+
+  // Location of an active uniform or attribute, -1 if the linker dropped it.
+  // Arrays are found both as "name" and "name[0]".
+  GLint uniform(const std::string& name) const;
+  GLint attribute(const std::string& name) const;
+
+  const std::unordered_map<std::string, Variable>& uniforms() const { return uniforms_; }
+  const std::unordered_map<std::string, Variable>& attributes() const { return attributes_; }
+
+  double buildMs() const { return buildMs_; }
+  uint64_t useCount() const { return useCount_; }
+  unsigned int requests() const { return requests_; }
+
+private:
+  friend class ShaderLibrary;
+
+  void reflect();
+
+  GLuint id_;
+  std::string name_;
+  std::unordered_map<std::string, Variable> uniforms_;
+  std::unordered_map<std::string, Variable> attributes_;
+  double buildMs_;
+  uint64_t useCount_;
+  unsigned int requests_;
+};
+
+// Locations of a fixed list of uniforms, for one object. They are resolved
+// from the program's reflection table the first time the object is drawn with
+// a program and reused until it is drawn with a different one, so draws only
+// pass integer handles to the driver.
+class UniformLocations
+{
+public:
+  explicit UniformLocations(std::vector<std::string> names);
+
+  void resolve(const ShaderProgram& program);
+
+  GLint operator[](size_t index) const { return locations_[index]; }
+  size_t size() const { return names_.size(); }
+
+  // Old behaviour for comparison: glGetUniformLocation for every name on every
+  // resolve(), as the draws used to do.
+  static void setLookupEveryDraw(bool enabled);
+
+private:
+  std::vector<std::string> names_;
+  std::vector<GLint> locations_;
+  GLuint program_;
+};
+
+// Hands out one linked program per unique vertex/fragment source pair. Sources
+// are keyed by content, so two files with the same text share a program.
+class ShaderLibrary
+{
+public:
+  static ShaderLibrary& instance();
+
+  // Reads both files and returns the shared program for their contents,
+  // building it on first use. Never returns null; a program that failed to
+  // compile is kept (with id 0 if it could not be read) so the error is only
+  // reported once.
+  ShaderProgram& load(const std::string& vertexPath, const std::string& fragmentPath);
+
+  size_t size() const { return programs_.size(); }
+
+  // Attaches the uniform block called name to a buffer binding point, in every
+  // program that declares it, now and whenever a program is built later.
+  // GLSL 4.10 has no layout(binding = N), so this is done after linking.
+  void bindUniformBlock(const std::string& name, GLuint binding);
+
+  // Per-program build time, use count and how many callers share it
+  void printStats() const;
+
+  // Deletes every program. Call before the GL context goes away.
+  void clear();
+
+private:
+  ShaderLibrary() = default;
+
+  void applyUniformBlocks(const ShaderProgram& program) const;
+
+  std::unordered_map<uint64_t, std::unique_ptr<ShaderProgram>> programs_;
+  std::unordered_map<std::string, GLuint> uniformBlocks_;
+};
+
+#endif
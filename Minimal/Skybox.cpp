@@ -1,4 +1,5 @@
 ﻿#include "Skybox.h"
+#include "GlCallCounter.h"
 
 #include <GL/glew.h>
 #include <iostream>
@@ -9,16 +10,20 @@ Skybox::Skybox(const std::string dir) : TexturedCube(dir)
 {
 }
 
+Skybox::Skybox(const std::string dir, CubemapLoader& loader) : TexturedCube(dir, loader)
+{
+}
+
 Skybox::~Skybox()
 {
 }
 
-void Skybox::draw(unsigned skyboxShader, const glm::mat4& p, const glm::mat4& v)
+void Skybox::draw(ShaderProgram& skyboxShader, int eye)
 {
-  glEnable(GL_CULL_FACE);
-  glCullFace(GL_BACK);
-  glDepthMask(GL_FALSE);
-  TexturedCube::draw(skyboxShader, p, glm::mat4(glm::mat3(v)));
-  glDepthMask(GL_TRUE);
-  glCullFace(GL_FRONT);
+  glCounted::Enable(GL_CULL_FACE);
+  glCounted::CullFace(GL_BACK);
+  glCounted::DepthMask(GL_FALSE);
+  TexturedCube::draw(skyboxShader, eye);
+  glCounted::DepthMask(GL_TRUE);
+  glCounted::CullFace(GL_FRONT);
 }
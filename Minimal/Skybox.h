@@ -9,8 +9,11 @@ class Skybox : public TexturedCube
 public:
 
   Skybox(const std::string dir);
+  Skybox(const std::string dir, CubemapLoader& loader);
   ~Skybox();
 
-  void draw(unsigned int skyboxShader, const glm::mat4& p, const glm::mat4& v);
+  // skyboxShader drops the view translation itself (see skybox.vert).
+  // eye >= 0 limits a single-pass stereo draw to that eye.
+  void draw(ShaderProgram& skyboxShader, int eye = -1);
 };
 #endif
@@ -0,0 +1,80 @@
+#ifndef SPSCHISTORY_H
+#define SPSCHISTORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// The last Capacity values written by one producer thread, readable by one
+// consumer thread without locks or allocation. The producer never waits: it
+// overwrites the oldest entry. Entries are numbered from 0 in push order and a
+// read of an entry the producer has since overwritten (or is overwriting)
+// fails instead of returning a torn value.
+template <typename T, size_t Capacity>
+class SpscHistory
+{
+  static_assert(std::is_trivially_copyable<T>::value, "entries are copied while the producer may be writing");
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  static const size_t CAPACITY = Capacity;
+
+  SpscHistory() : count_(0)
+  {
+    for (Slot& slot : slots_)
+    {
+      slot.version.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  SpscHistory(const SpscHistory&) = delete;
+  SpscHistory& operator=(const SpscHistory&) = delete;
+
+  // Producer only
+  void push(const T& value)
+  {
+    uint64_t index = count_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[index & (Capacity - 1)];
+    // Odd while the value is being written; readers that see it, or see it
+    // change under them, retry or give up
+    slot.version.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.value = value;
+    slot.version.store(2 * index + 2, std::memory_order_release);
+    count_.store(index + 1, std::memory_order_release);
+  }
+
+  // Number of values pushed so far; the newest is count() - 1
+  uint64_t count() const
+  {
+    return count_.load(std::memory_order_acquire);
+  }
+
+  // Consumer: copies entry index into value. False if it has not been pushed
+  // yet or has already been overwritten.
+  bool read(uint64_t index, T& value) const
+  {
+    const Slot& slot = slots_[index & (Capacity - 1)];
+    uint64_t version = slot.version.load(std::memory_order_acquire);
+    if (version != 2 * index + 2)
+    {
+      return false;
+    }
+    value = slot.value;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.version.load(std::memory_order_relaxed) == version;
+  }
+
+private:
+  struct Slot
+  {
+    std::atomic<uint64_t> version;
+    T value;
+  };
+
+  Slot slots_[Capacity];
+  std::atomic<uint64_t> count_;
+};
+
+#endif
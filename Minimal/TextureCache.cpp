@@ -0,0 +1,158 @@
+#include "TextureCache.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef GL_SRGB8
+#define GL_SRGB8 0x8C41
+#endif
+#ifndef GL_SRGB8_ALPHA8
+#define GL_SRGB8_ALPHA8 0x8C43
+#endif
+
+// Absolute path with . and .. resolved (and symlinks, where the platform can),
+// so one file reached by two relative paths is one texture. Falls back to the
+// path as given if the file is not there.
+static std::string canonicalPath(const std::string& path)
+{
+#ifdef _WIN32
+  char full[_MAX_PATH];
+  if (!_fullpath(full, path.c_str(), _MAX_PATH))
+  {
+    return path;
+  }
+  // Windows paths are case-insensitive and take either separator
+  std::string canonical(full);
+  for (char& c : canonical)
+  {
+    c = c == '\\' ? '/' : static_cast<char>(tolower(static_cast<unsigned char>(c)));
+  }
+  return canonical;
+#else
+  char* full = realpath(path.c_str(), nullptr);
+  if (!full)
+  {
+    return path;
+  }
+  std::string canonical(full);
+  free(full);
+  return canonical;
+#endif
+}
+
+// The loader Model used before the cache: stb_image, then mipmaps and
+// repeat wrapping. bytes is the estimated GPU size, 0 if loading failed.
+static GLuint loadTexture(const std::string& path, bool gamma, uint64_t& bytes)
+{
+  GLuint textureID;
+  glGenTextures(1, &textureID);
+  bytes = 0;
+
+  int width, height, nrComponents;
+  unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
+  if (data)
+  {
+    GLenum format = GL_RGBA;
+    if (nrComponents == 1)
+      format = GL_RED;
+    else if (nrComponents == 3)
+      format = GL_RGB;
+    else if (nrComponents == 4)
+      format = GL_RGBA;
+    GLenum internalFormat = format;
+    if (gamma && nrComponents == 3)
+      internalFormat = GL_SRGB8;
+    else if (gamma && nrComponents == 4)
+      internalFormat = GL_SRGB8_ALPHA8;
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    for (int w = width, h = height;; w = std::max(1, w / 2), h = std::max(1, h / 2))
+    {
+      bytes += uint64_t(w) * h * nrComponents;
+      if (w == 1 && h == 1)
+      {
+        break;
+      }
+    }
+    stbi_image_free(data);
+  }
+  else
+  {
+    printf("Texture failed to load at path: %s\n", path.c_str());
+  }
+
+  return textureID;
+}
+
+TextureCache& TextureCache::instance()
+{
+  static TextureCache cache;
+  return cache;
+}
+
+GLuint TextureCache::acquire(const std::string& path, bool gamma)
+{
+  std::string key = canonicalPath(path) + (gamma ? "|srgb" : "|linear");
+  requests_++;
+  auto found = textures_.find(key);
+  if (found != textures_.end())
+  {
+    hits_++;
+    bytesSaved_ += found->second.bytes;
+    found->second.references++;
+    return found->second.id;
+  }
+
+  Entry entry;
+  entry.id = loadTexture(path, gamma, entry.bytes);
+  entry.references = 1;
+  textures_.emplace(key, entry);
+  keys_.emplace(entry.id, key);
+  return entry.id;
+}
+
+void TextureCache::release(GLuint id)
+{
+  auto key = keys_.find(id);
+  if (key == keys_.end())
+  {
+    return;
+  }
+  auto found = textures_.find(key->second);
+  if (--found->second.references == 0)
+  {
+    glDeleteTextures(1, &id);
+    textures_.erase(found);
+    keys_.erase(key);
+  }
+}
+
+void TextureCache::printStats() const
+{
+  printf("Texture cache: %u requests, %u hits (%.0f%%), %.1f MB of uploads saved, %u textures still held\n",
+         requests_, hits_, requests_ ? 100.0 * hits_ / requests_ : 0.0, bytesSaved_ / (1024.0 * 1024.0),
+         static_cast<unsigned int>(textures_.size()));
+}
+
+void TextureCache::clear()
+{
+  for (const auto& entry : textures_)
+  {
+    glDeleteTextures(1, &entry.second.id);
+  }
+  textures_.clear();
+  keys_.clear();
+}
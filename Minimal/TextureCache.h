@@ -0,0 +1,59 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Hands out one GL texture per image file, shared by every model that uses it.
+// Textures are keyed by canonical absolute path and gamma, and reference
+// counted: the texture is deleted when its last user releases it.
+class TextureCache
+{
+public:
+  static TextureCache& instance();
+
+  // The texture for the image at path, with mipmaps, loaded on first use.
+  // gamma stores colour images as sRGB. An image that failed to load is kept
+  // as an empty texture so the error is only reported once. Every acquire
+  // must be matched by a release.
+  GLuint acquire(const std::string& path, bool gamma);
+  void release(GLuint id);
+
+  size_t size() const { return textures_.size(); }
+
+  // Requests, hit rate and the upload bytes the hits saved
+  void printStats() const;
+
+  // Deletes every texture, released or not. Call before the GL context goes away.
+  void clear();
+
+private:
+  TextureCache() = default;
+
+  struct Entry
+  {
+    GLuint id;
+    unsigned int references;
+    // Estimated GPU size including the mip chain
+    uint64_t bytes;
+  };
+
+  // Canonical path + gamma
+  std::unordered_map<std::string, Entry> textures_;
+  std::unordered_map<GLuint, std::string> keys_;
+
+  unsigned int requests_{0};
+  unsigned int hits_{0};
+  uint64_t bytesSaved_{0};
+};
+
+#endif
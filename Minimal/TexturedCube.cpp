@@ -1,78 +1,42 @@
 ﻿#include "TexturedCube.h"
+#include "CameraUniforms.h"
+#include "CubemapCache.h"
+#include "CubemapLoader.h"
+#include "GlCallCounter.h"
+#include "PnmImage.h"
 #include <GL/glew.h>
 #include <iostream>
 #include <vector>
 
-unsigned char* loadPPM(const char* filename, int& width, int& height)
-{
-  const int BUFSIZE = 128;
-  FILE* fp;
-  unsigned int read;
-  unsigned char* rawData;
-  char buf[3][BUFSIZE];
-  char* retval_fgets;
-  size_t retval_sscanf;
-
-  if ((fp = fopen(filename, "rb")) == NULL)
-  {
-    std::cerr << "error reading ppm file, could not locate " << filename << std::endl;
-    width = 0;
-    height = 0;
-    return NULL;
-  }
-
-  // Read magic number:
-  retval_fgets = fgets(buf[0], BUFSIZE, fp);
-
-  // Read width and height:
-  do
-  {
-    retval_fgets = fgets(buf[0], BUFSIZE, fp);
-  }
-  while (buf[0][0] == '#');
-  retval_sscanf = sscanf(buf[0], "%s %s", buf[1], buf[2]);
-  width = atoi(buf[1]);
-  height = atoi(buf[2]);
-
-  // Read maxval:
-  do
-  {
-    retval_fgets = fgets(buf[0], BUFSIZE, fp);
-  }
-  while (buf[0][0] == '#');
-
-  // Read image data:
-  rawData = new unsigned char[width * height * 3];
-  read = fread(rawData, width * height * 3, 1, fp);
-  fclose(fp);
-  if (read != 1)
-  {
-    std::cerr << "error parsing ppm file, incomplete data" << std::endl;
-    delete[] rawData;
-    width = 0;
-    height = 0;
-    return NULL;
-  }
-
-  return rawData;
-}
-
 unsigned loadCubemap(const std::string directory, std::vector<std::string>& faces)
 {
   unsigned int textureID;
   glGenTextures(1, &textureID);
   glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
-  int width, height;
+  // Prefer the baked container: one mapped file with the mip chain included
+  CubemapCache cache;
+  if (cache.open(directory, faces))
+  {
+    cache.upload();
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    return textureID;
+  }
+  std::cout << "No up to date cubemap bake in " << directory
+    << ", loading PPM faces (run with --bake-cubemaps to bake)" << std::endl;
+
+  PnmImage image;
   for (unsigned int i = 0; i < faces.size(); i++)
   {
     std::string path = directory + faces[i];
-    unsigned char* data = loadPPM(path.c_str(), width, height);
-    if (data)
+    if (image.open(path))
     {
-      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                   0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data
-      );
+      // Straight from the mapped file, no intermediate copy
+      image.upload(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0);
     }
     else
     {
@@ -98,33 +62,147 @@ std::vector<std::string> faces
   "front.ppm"
 };
 
-TexturedCube::TexturedCube(const std::string dir) : Cube()
+const std::vector<std::string>& cubemapFaces()
+{
+  return faces;
+}
+
+bool bakeCubemapDirectory(const std::string dir)
+{
+  return bakeCubemap("./" + dir + "/", faces);
+}
+
+// 1x1 mid grey cubemap drawn in place of maps that are still loading
+static unsigned int placeholderCubemap()
+{
+  static unsigned int textureID = 0;
+  if (!textureID)
+  {
+    const unsigned char grey[3] = {128, 128, 128};
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    for (unsigned int i = 0; i < 6; i++)
+    {
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, grey);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  }
+  return textureID;
+}
+
+TexturedCube::TexturedCube(const std::string dir)
+  : Cube(), instanceBuffer(0), instanceCount(0), instanceDivisor(1), cubeUniforms({ "model", "skybox", "onlyEye" })
 {
   cubeMap = loadCubemap("./" + dir + "/", faces);
 }
 
+TexturedCube::TexturedCube(const std::string dir, CubemapLoader& loader)
+  : Cube(), instanceBuffer(0), instanceCount(0), instanceDivisor(1), cubeUniforms({ "model", "skybox", "onlyEye" })
+{
+  cubeMap = 0;
+  loader.load(this, "./" + dir + "/");
+}
+
 TexturedCube::~TexturedCube()
 {
   glDeleteTextures(1, &cubeMap);
+  glDeleteBuffers(1, &instanceBuffer);
 }
 
-void TexturedCube::draw(unsigned shader, const glm::mat4& p, const glm::mat4& v)
+void TexturedCube::draw(ShaderProgram& shader, int eye)
 {
-  glUseProgram(shader);
-  // ... set view and projection matrix
-  uProjection = glGetUniformLocation(shader, "projection");
-  uView = glGetUniformLocation(shader, "view");
+  shader.use();
+  // ... view and projection come from the Camera block, we only set the model matrix
+  cubeUniforms.resolve(shader);
+  glUniformMatrix4fv(cubeUniforms[U_MODEL], 1, GL_FALSE, &toWorld[0][0]);
+  glUniform1i(cubeUniforms[U_ONLY_EYE], eye);
 
-  glm::mat4 modelview = v * toWorld;
+  glBindVertexArray(VAO);
+  glActiveTexture(GL_TEXTURE0);
+  glCounted::BindTexture(GL_TEXTURE_CUBE_MAP, resident() ? cubeMap : placeholderCubemap());
+  glUniform1i(cubeUniforms[U_SKYBOX], 0);
+  glDrawArraysInstanced(GL_TRIANGLES, 0, 36, eye >= 0 ? 1 : CameraUniforms::eyeCount());
+  glBindVertexArray(0);
+}
 
-  // Now send these values to the shader program
-  glUniformMatrix4fv(uProjection, 1, GL_FALSE, &p[0][0]);
-  glUniformMatrix4fv(uView, 1, GL_FALSE, &modelview[0][0]);
+unsigned int TexturedCube::setMaxSize(unsigned int size)
+{
+  if (!resident())
+  {
+    return 0;
+  }
+  glBindTexture(GL_TEXTURE_CUBE_MAP, cubeMap);
+  // The PPM fallback only has level 0 and leaves GL_TEXTURE_MAX_LEVEL at its default
+  GLint maxLevel = 0;
+  glGetTexParameteriv(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+  GLint level = 0, width = 0;
+  glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_TEXTURE_WIDTH, &width);
+  while (level < maxLevel && static_cast<unsigned int>(width) > size)
+  {
+    GLint next = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, level + 1, GL_TEXTURE_WIDTH, &next);
+    if (next == 0)
+    {
+      break;
+    }
+    ++level;
+    width = next;
+  }
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, level);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+  return static_cast<unsigned int>(width);
+}
 
+void TexturedCube::setInstances(const std::vector<glm::mat4>& models)
+{
   glBindVertexArray(VAO);
+  if (!instanceBuffer)
+  {
+    // A mat4 attribute takes four consecutive locations, one column each
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (unsigned int column = 0; column < 4; column++)
+    {
+      glEnableVertexAttribArray(2 + column);
+      glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                            (GLvoid*)(column * sizeof(glm::vec4)));
+      glVertexAttribDivisor(2 + column, instanceDivisor);
+    }
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  // Respecifying orphans the old storage, so this never waits on frames still in flight
+  glBufferData(GL_ARRAY_BUFFER, models.size() * sizeof(glm::mat4), models.empty() ? nullptr : &models[0],
+               GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  instanceCount = static_cast<int>(models.size());
+}
+
+void TexturedCube::drawInstanced(ShaderProgram& shader)
+{
+  if (!instanceCount)
+  {
+    return;
+  }
+  shader.use();
+  cubeUniforms.resolve(shader);
+  glUniformMatrix4fv(cubeUniforms[U_MODEL], 1, GL_FALSE, &toWorld[0][0]);
+
+  glBindVertexArray(VAO);
+  // With both eyes in one pass, each model matrix is used for eyeCount instances in a row
+  GLsizei eyes = CameraUniforms::eyeCount();
+  if (instanceDivisor != eyes)
+  {
+    for (unsigned int column = 0; column < 4; column++)
+    {
+      glVertexAttribDivisor(2 + column, eyes);
+    }
+    instanceDivisor = eyes;
+  }
   glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_CUBE_MAP, cubeMap);
-  glUniform1i(glGetUniformLocation(shader, "skybox"), 0);
-  glDrawArrays(GL_TRIANGLES, 0, 36);
+  glCounted::BindTexture(GL_TEXTURE_CUBE_MAP, resident() ? cubeMap : placeholderCubemap());
+  glUniform1i(cubeUniforms[U_SKYBOX], 0);
+  glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instanceCount * eyes);
   glBindVertexArray(0);
 }
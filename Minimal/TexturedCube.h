@@ -3,18 +3,51 @@
 
 #include "Cube.h"
 #include <string>
+#include <vector>
+
+class CubemapLoader;
+
+// Bakes ./dir/ into a CubemapCache file so later runs can skip the PPM faces.
+bool bakeCubemapDirectory(const std::string dir);
+
+// File names of the six faces in GL_TEXTURE_CUBE_MAP_POSITIVE_X + i order
+const std::vector<std::string>& cubemapFaces();
 
 class TexturedCube : public Cube
 {
 public:
 
   TexturedCube(const std::string dir);
+  // Loads in the background; draws a placeholder until the loader is done
+  TexturedCube(const std::string dir, CubemapLoader& loader);
   ~TexturedCube();
 
-  void draw(unsigned int shader, const glm::mat4& p, const glm::mat4& v);
+  // eye >= 0 draws into that eye only, for shaders with an onlyEye uniform
+  // (skybox.vert); otherwise the cube is drawn into every eye of the pass
+  void draw(ShaderProgram& shader, int eye = -1);
+
+  // Model matrices for drawInstanced, fed to attribute locations 2-5
+  void setInstances(const std::vector<glm::mat4>& models);
+  // Every instance in one draw call, each placed by toWorld * its own model
+  // matrix. Needs an instanced shader such as texturedcube_instanced.vert.
+  void drawInstanced(ShaderProgram& shader);
+
+  bool resident() const { return cubeMap != 0; }
+
+  // Samples from the first mip level whose faces are no larger than size,
+  // as if the cubemap had been loaded that small; only levels that were
+  // uploaded count. Returns the face size now sampled, 0 while not resident.
+  unsigned int setMaxSize(unsigned int size);
 
   // These variables are needed for the shader program
   unsigned int cubeMap;
-  unsigned int uProjection, uView;
+  unsigned int instanceBuffer;
+  int instanceCount;
+  // Instances per model matrix, the eye count the divisors were last set for
+  int instanceDivisor;
+
+private:
+  enum { U_MODEL, U_SKYBOX, U_ONLY_EYE };
+  UniformLocations cubeUniforms;
 };
 #endif
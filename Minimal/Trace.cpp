@@ -0,0 +1,206 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdio>
+
+// Track of the GPU zones, after any real thread's
+static const uint32_t GPU_THREAD = 1000;
+
+TraceCapture& TraceCapture::instance()
+{
+  static TraceCapture capture;
+  return capture;
+}
+
+TraceCapture::TraceCapture() : capturing_(false), startNs_(0), gpuCalibrated_(false), gpuToCpuNs_(0)
+{
+}
+
+TraceCapture::ThreadBuffer& TraceCapture::threadBuffer()
+{
+  static thread_local ThreadBuffer* buffer = nullptr;
+  if (!buffer)
+  {
+    std::lock_guard<std::mutex> lock(threadsMutex_);
+    std::shared_ptr<ThreadBuffer> created = std::make_shared<ThreadBuffer>();
+    created->id = static_cast<uint32_t>(threads_.size() + 1);
+    created->dropped = 0;
+    threads_.push_back(created);
+    buffer = created.get();
+  }
+  return *buffer;
+}
+
+int64_t TraceCapture::sinceStart(Clock::time_point time) const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count() -
+    startNs_.load(std::memory_order_acquire);
+}
+
+void TraceCapture::start()
+{
+  capturing_ = false;
+  {
+    std::lock_guard<std::mutex> lock(threadsMutex_);
+    for (auto& thread : threads_)
+    {
+      std::lock_guard<std::mutex> threadLock(thread->mutex);
+      thread->events.clear();
+      thread->dropped = 0;
+    }
+  }
+  gpuEvents_.clear();
+  gpuCalibrated_ = false;
+  startNs_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count(),
+                 std::memory_order_release);
+  capturing_.store(true, std::memory_order_release);
+  printf("Trace capture started\n");
+}
+
+void TraceCapture::setThreadName(const char* name)
+{
+  ThreadBuffer& buffer = threadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.name = name;
+}
+
+void TraceCapture::add(ThreadBuffer& buffer, const Event& event)
+{
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (buffer.events.size() >= MAX_EVENTS_PER_THREAD)
+  {
+    buffer.dropped++;
+    return;
+  }
+  buffer.events.push_back(event);
+  buffer.events.back().thread = buffer.id;
+}
+
+void TraceCapture::zone(const char* name, const char* category, Clock::time_point begin, Clock::time_point end,
+                        const char* arg0, double value0, const char* arg1, double value1)
+{
+  int64_t from = std::max<int64_t>(0, sinceStart(begin));
+  Event event = { name, category, 'X', 0, from, std::max<int64_t>(0, sinceStart(end) - from),
+                  { arg0, arg1 }, { value0, value1 } };
+  add(threadBuffer(), event);
+}
+
+void TraceCapture::instant(const char* name, const char* category, Clock::time_point time, const char* arg0,
+                           double value0, const char* arg1, double value1)
+{
+  Event event = { name, category, 'i', 0, sinceStart(time), 0, { arg0, arg1 }, { value0, value1 } };
+  add(threadBuffer(), event);
+}
+
+void TraceCapture::calibrateGpu(int64_t gpuNs, Clock::time_point cpu)
+{
+  gpuToCpuNs_ = sinceStart(cpu) - gpuNs;
+  gpuCalibrated_ = true;
+}
+
+void TraceCapture::gpuZone(const char* name, const char* category, uint64_t beginNs, uint64_t endNs)
+{
+  if (!gpuCalibrated_ || gpuEvents_.size() >= MAX_EVENTS_PER_THREAD)
+  {
+    return;
+  }
+  int64_t from = static_cast<int64_t>(beginNs) + gpuToCpuNs_;
+  Event event = { name, category, 'X', GPU_THREAD, from, static_cast<int64_t>(endNs - beginNs),
+                  { nullptr, nullptr }, { 0.0, 0.0 } };
+  gpuEvents_.push_back(event);
+}
+
+static void writeEvent(FILE* file, bool& first, const char* name, const char* category, char phase,
+                       uint32_t thread, int64_t time, int64_t duration, const char* const argNames[2],
+                       const double args[2])
+{
+  fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f", first ? "" : ",",
+          name, category, phase, thread, time / 1000.0);
+  first = false;
+  if (phase == 'X')
+  {
+    fprintf(file, ",\"dur\":%.3f", duration / 1000.0);
+  }
+  else if (phase == 'i')
+  {
+    fprintf(file, ",\"s\":\"t\"");
+  }
+  if (argNames[0] || argNames[1])
+  {
+    fprintf(file, ",\"args\":{");
+    bool firstArg = true;
+    for (int i = 0; i < 2; i++)
+    {
+      if (argNames[i])
+      {
+        fprintf(file, "%s\"%s\":%.9g", firstArg ? "" : ",", argNames[i], args[i]);
+        firstArg = false;
+      }
+    }
+    fprintf(file, "}");
+  }
+  fprintf(file, "}");
+}
+
+static void writeThreadName(FILE* file, bool& first, uint32_t thread, const std::string& name)
+{
+  fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+          first ? "" : ",", thread, name.c_str());
+  first = false;
+}
+
+bool TraceCapture::stop(const std::string& path)
+{
+  if (!capturing_)
+  {
+    return false;
+  }
+  capturing_ = false;
+
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file)
+  {
+    printf("Unable to write trace to %s\n", path.c_str());
+    return false;
+  }
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  bool first = true;
+  size_t events = 0, dropped = 0;
+  {
+    std::lock_guard<std::mutex> lock(threadsMutex_);
+    for (auto& thread : threads_)
+    {
+      std::lock_guard<std::mutex> threadLock(thread->mutex);
+      if (thread->events.empty())
+      {
+        continue;
+      }
+      char fallback[32];
+      snprintf(fallback, sizeof(fallback), "thread %u", thread->id);
+      writeThreadName(file, first, thread->id, thread->name.empty() ? fallback : thread->name);
+      for (const Event& e : thread->events)
+      {
+        writeEvent(file, first, e.name, e.category, e.phase, e.thread, e.time, e.duration, e.argNames, e.args);
+      }
+      events += thread->events.size();
+      dropped += thread->dropped;
+      thread->events.clear();
+    }
+  }
+  if (!gpuEvents_.empty())
+  {
+    writeThreadName(file, first, GPU_THREAD, "GPU");
+    for (const Event& e : gpuEvents_)
+    {
+      writeEvent(file, first, e.name, e.category, e.phase, e.thread, e.time, e.duration, e.argNames, e.args);
+    }
+    events += gpuEvents_.size();
+    gpuEvents_.clear();
+  }
+  fprintf(file, "\n]}\n");
+  bool ok = ferror(file) == 0;
+  fclose(file);
+  printf("Trace capture stopped: %u events (%u dropped) written to %s\n", static_cast<unsigned int>(events),
+         static_cast<unsigned int>(dropped), path.c_str());
+  return ok;
+}
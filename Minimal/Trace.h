@@ -0,0 +1,130 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Timeline capture in Chrome's Trace Event JSON format, which chrome://tracing
+// and ui.perfetto.dev open directly. Any thread may add zones while a capture
+// runs; each thread appends to its own buffer, so threads never contend with
+// each other, and outside a capture a zone costs one atomic load.
+//
+// Names, categories and argument names are stored as pointers and must be
+// string literals (or otherwise outlive the capture).
+class TraceCapture
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  // Per thread, so a capture stays bounded if it is left running
+  static const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+  static TraceCapture& instance();
+
+  // Drops whatever an earlier capture left and starts a new one
+  void start();
+  // Ends the capture and writes it; false if there was none or the file
+  // could not be written
+  bool stop(const std::string& path);
+
+  // Acquire pairs with start(), so a thread that sees a capture also sees its start time
+  bool capturing() const { return capturing_.load(std::memory_order_acquire); }
+
+  // Shown as the calling thread's track name
+  void setThreadName(const char* name);
+
+  // A zone on the calling thread. Up to two numeric arguments, ignored when
+  // their name is null.
+  void zone(const char* name, const char* category, Clock::time_point begin, Clock::time_point end,
+            const char* arg0 = nullptr, double value0 = 0.0, const char* arg1 = nullptr, double value1 = 0.0);
+  // A point in time on the calling thread
+  void instant(const char* name, const char* category, Clock::time_point time, const char* arg0 = nullptr,
+               double value0 = 0.0, const char* arg1 = nullptr, double value1 = 0.0);
+
+  // GPU timestamps (GL_TIMESTAMP, in nanoseconds) are moved onto the CPU clock
+  // with the offset from the last calibration, one GL_TIMESTAMP read together
+  // with the steady clock. Recalibrate now and then; the clocks drift.
+  void calibrateGpu(int64_t gpuNs, Clock::time_point cpu);
+  bool gpuCalibrated() const { return gpuCalibrated_; }
+  // A zone on the GPU track
+  void gpuZone(const char* name, const char* category, uint64_t beginNs, uint64_t endNs);
+
+private:
+  struct Event
+  {
+    const char* name;
+    const char* category;
+    char phase;
+    uint32_t thread;
+    // Nanoseconds since the capture started
+    int64_t time;
+    int64_t duration;
+    const char* argNames[2];
+    double args[2];
+  };
+
+  struct ThreadBuffer
+  {
+    std::mutex mutex;
+    uint32_t id;
+    std::string name;
+    std::vector<Event> events;
+    size_t dropped;
+  };
+
+  TraceCapture();
+
+  ThreadBuffer& threadBuffer();
+  void add(ThreadBuffer& buffer, const Event& event);
+  int64_t sinceStart(Clock::time_point time) const;
+
+  std::atomic<bool> capturing_;
+  // Clock::time_point of the capture's start, in nanoseconds since the clock's epoch. Atomic
+  // because other threads' zones read it while start() may be setting it for a new capture.
+  std::atomic<int64_t> startNs_;
+  // Every thread that ever added an event; buffers outlive their threads
+  std::mutex threadsMutex_;
+  std::vector<std::shared_ptr<ThreadBuffer>> threads_;
+  // GPU zones are added by the GL thread only
+  std::vector<Event> gpuEvents_;
+  bool gpuCalibrated_;
+  int64_t gpuToCpuNs_;
+};
+
+// Adds the enclosing scope as a zone when a capture is running
+class TraceZone
+{
+public:
+  explicit TraceZone(const char* name, const char* category = "cpu")
+    : name_(name), category_(category), active_(TraceCapture::instance().capturing())
+  {
+    if (active_)
+    {
+      begin_ = TraceCapture::Clock::now();
+    }
+  }
+
+  ~TraceZone()
+  {
+    if (active_)
+    {
+      TraceCapture::instance().zone(name_, category_, begin_, TraceCapture::Clock::now());
+    }
+  }
+
+  TraceZone(const TraceZone&) = delete;
+  TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+  const char* name_;
+  const char* category_;
+  bool active_;
+  TraceCapture::Clock::time_point begin_;
+};
+
+#endif
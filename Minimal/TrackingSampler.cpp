@@ -0,0 +1,89 @@
+#include "TrackingSampler.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+TrackingSampler::TrackingSampler(HmdBackend& hmd, double rateHz, Sink sink)
+  : hmd_(hmd), rateHz_(rateHz), sink_(std::move(sink)), running_(false), frame_(0), stats_()
+{
+}
+
+TrackingSampler::~TrackingSampler()
+{
+  stop();
+}
+
+void TrackingSampler::start()
+{
+  if (running_)
+  {
+    return;
+  }
+  stats_ = Stats();
+  running_ = true;
+  thread_ = std::thread(&TrackingSampler::run, this);
+}
+
+void TrackingSampler::stop()
+{
+  running_ = false;
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+}
+
+void TrackingSampler::run()
+{
+  typedef std::chrono::steady_clock Clock;
+  const Clock::duration period =
+    std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rateHz_));
+  const Clock::duration spin = std::chrono::milliseconds(2);
+
+  TraceCapture::instance().setThreadName("tracking sampler");
+  Clock::time_point begin = Clock::now();
+  Clock::time_point next = begin;
+  Clock::time_point last = begin;
+  while (running_.load(std::memory_order_relaxed))
+  {
+    {
+      TraceZone zone("sample", "tracking");
+      // 0 asks for the latest sensor reading rather than a prediction
+      ovrTrackingState tracking = hmd_.trackingState(0.0, false);
+      sink_(makePoseSample(tracking, frame_.load(std::memory_order_relaxed)));
+    }
+
+    Clock::time_point now = Clock::now();
+    if (stats_.samples > 0)
+    {
+      stats_.maxGapMs = std::max(stats_.maxGapMs, std::chrono::duration<double, std::milli>(now - last).count());
+    }
+    last = now;
+    stats_.samples++;
+
+    next += period;
+    if (next < now)
+    {
+      // Fell behind (the thread was descheduled); do not try to catch up in a burst
+      next = now;
+    }
+    if (next - now > spin)
+    {
+      std::this_thread::sleep_until(next - spin);
+    }
+    while (Clock::now() < next)
+    {
+      std::this_thread::yield();
+    }
+  }
+  stats_.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+void TrackingSampler::printStats() const
+{
+  printf("Tracking sampler: %llu samples in %.1f s, %.0f Hz (asked for %.0f Hz), longest gap %.2f ms\n",
+         static_cast<unsigned long long>(stats_.samples), stats_.seconds,
+         stats_.seconds > 0 ? stats_.samples / stats_.seconds : 0.0, rateHz_, stats_.maxGapMs);
+}
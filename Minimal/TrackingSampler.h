@@ -0,0 +1,64 @@
+#ifndef TRACKINGSAMPLER_H
+#define TRACKINGSAMPLER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "HmdBackend.h"
+#include "PoseHistory.h"
+
+// Polls HmdBackend::trackingState on its own thread at a fixed rate and hands
+// each sample to a sink, typically PoseHistory::push. The sink runs on the
+// sampler thread and is its only producer, so nothing else may push to the
+// same history while the sampler runs. The backend must allow tracking queries
+// from another thread.
+//
+// Waits shorter than a couple of milliseconds are spun (with yields), since
+// sleeps are not that precise; above ~500 Hz this keeps most of a core busy.
+class TrackingSampler
+{
+public:
+  typedef std::function<void(const PoseSample&)> Sink;
+
+  struct Stats
+  {
+    uint64_t samples;
+    double seconds;
+    // Longest time between two samples
+    double maxGapMs;
+  };
+
+  TrackingSampler(HmdBackend& hmd, double rateHz, Sink sink);
+  // Stops the thread if it is still running
+  ~TrackingSampler();
+
+  TrackingSampler(const TrackingSampler&) = delete;
+  TrackingSampler& operator=(const TrackingSampler&) = delete;
+
+  void start();
+  void stop();
+
+  // Render frame to tag the following samples with
+  void setFrame(uint64_t frame) { frame_.store(frame, std::memory_order_relaxed); }
+
+  double rateHz() const { return rateHz_; }
+
+  // Totals so far; only consistent once the thread has stopped
+  Stats stats() const { return stats_; }
+  void printStats() const;
+
+private:
+  void run();
+
+  HmdBackend& hmd_;
+  double rateHz_;
+  Sink sink_;
+  std::thread thread_;
+  std::atomic<bool> running_;
+  std::atomic<uint64_t> frame_;
+  Stats stats_;
+};
+
+#endif
@@ -0,0 +1,200 @@
+#include "VertexPacking.h"
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const float UNORM16_MAX = 65535.0f;
+static const float SNORM16_MAX = 32767.0f;
+
+uint16_t floatToHalf(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint32_t sign = (bits >> 16) & 0x8000;
+  uint32_t exponent = (bits >> 23) & 0xff;
+  uint32_t mantissa = bits & 0x7fffff;
+  if (exponent == 0xff)
+  {
+    // Infinity stays infinity, NaN stays a (quiet) NaN
+    return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+  }
+
+  int halfExponent = int(exponent) - 127 + 15;
+  if (halfExponent >= 0x1f)
+  {
+    return static_cast<uint16_t>(sign | 0x7c00);
+  }
+  if (halfExponent <= 0)
+  {
+    // Subnormal half, or zero once even the leading bit is shifted out
+    if (halfExponent < -10)
+    {
+      return static_cast<uint16_t>(sign);
+    }
+    mantissa |= 0x800000;
+    uint32_t shift = 14 - halfExponent;
+    uint32_t half = mantissa >> shift;
+    uint32_t rest = mantissa & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (half & 1)))
+    {
+      ++half;
+    }
+    return static_cast<uint16_t>(sign | half);
+  }
+
+  // Round to nearest even; a carry out of the mantissa correctly bumps the exponent
+  uint32_t half = (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+  uint32_t rest = mantissa & 0x1fff;
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+  {
+    ++half;
+  }
+  return static_cast<uint16_t>(sign | half);
+}
+
+float halfToFloat(uint16_t half)
+{
+  uint32_t sign = uint32_t(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0)
+  {
+    float value = std::ldexp(float(mantissa), -24);
+    return sign ? -value : value;
+  }
+  else if (exponent == 0x1f)
+  {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  }
+  else
+  {
+    bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+  }
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static float signNotZero(float v)
+{
+  return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+void octEncode(const glm::vec3& v, int16_t encoded[2])
+{
+  // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the upper
+  float l1 = std::fabs(v.x) + std::fabs(v.y) + std::fabs(v.z);
+  float x = l1 > 0.0f ? v.x / l1 : 0.0f;
+  float y = l1 > 0.0f ? v.y / l1 : 0.0f;
+  if (l1 > 0.0f && v.z < 0.0f)
+  {
+    float foldedX = (1.0f - std::fabs(y)) * signNotZero(x);
+    float foldedY = (1.0f - std::fabs(x)) * signNotZero(y);
+    x = foldedX;
+    y = foldedY;
+  }
+  x = std::min(1.0f, std::max(-1.0f, x)) * SNORM16_MAX;
+  y = std::min(1.0f, std::max(-1.0f, y)) * SNORM16_MAX;
+
+  // Rounding each part on its own can land up to a whole cell off on the
+  // sphere; of the four corners around the point, keep the closest decode
+  glm::vec3 unit = l1 > 0.0f ? glm::normalize(v) : glm::vec3(0.0f, 0.0f, 1.0f);
+  float best = -2.0f;
+  for (int corner = 0; corner < 4; corner++)
+  {
+    int16_t candidate[2] = {static_cast<int16_t>(corner & 1 ? std::ceil(x) : std::floor(x)),
+                            static_cast<int16_t>(corner & 2 ? std::ceil(y) : std::floor(y))};
+    float similarity = glm::dot(octDecode(candidate), unit);
+    if (similarity > best)
+    {
+      best = similarity;
+      encoded[0] = candidate[0];
+      encoded[1] = candidate[1];
+    }
+  }
+}
+
+glm::vec3 octDecode(const int16_t encoded[2])
+{
+  float x = std::max(-1.0f, encoded[0] / SNORM16_MAX);
+  float y = std::max(-1.0f, encoded[1] / SNORM16_MAX);
+  float z = 1.0f - std::fabs(x) - std::fabs(y);
+  float t = std::max(-z, 0.0f);
+  x += x >= 0.0f ? -t : t;
+  y += y >= 0.0f ? -t : t;
+  return glm::normalize(glm::vec3(x, y, z));
+}
+
+PackedBounds packedBounds(const Vertex* vertices, size_t count)
+{
+  PackedBounds bounds;
+  if (count == 0)
+  {
+    bounds.offset = glm::vec3(0.0f);
+    bounds.scale = glm::vec3(0.0f);
+    return bounds;
+  }
+  glm::vec3 lo = vertices[0].Position, hi = vertices[0].Position;
+  for (size_t i = 1; i < count; i++)
+  {
+    const glm::vec3& p = vertices[i].Position;
+    lo = glm::vec3(std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z));
+    hi = glm::vec3(std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z));
+  }
+  bounds.offset = lo;
+  bounds.scale = hi - lo;
+  return bounds;
+}
+
+static uint16_t packUnorm16(float value, float offset, float scale)
+{
+  if (scale <= 0.0f)
+  {
+    return 0;
+  }
+  float unit = std::min(1.0f, std::max(0.0f, (value - offset) / scale));
+  return static_cast<uint16_t>(std::lround(unit * UNORM16_MAX));
+}
+
+void packVertices(const Vertex* vertices, size_t count, const PackedBounds& bounds, PackedVertex* packed)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    const Vertex& v = vertices[i];
+    PackedVertex& p = packed[i];
+    p.position[0] = packUnorm16(v.Position.x, bounds.offset.x, bounds.scale.x);
+    p.position[1] = packUnorm16(v.Position.y, bounds.offset.y, bounds.scale.y);
+    p.position[2] = packUnorm16(v.Position.z, bounds.offset.z, bounds.scale.z);
+    // Which way the bitangent points relative to cross(normal, tangent)
+    bool flipped = glm::dot(glm::cross(v.Normal, v.Tangent), v.Bitangent) < 0.0f;
+    p.position[3] = flipped ? 0 : 0xffff;
+    octEncode(v.Normal, p.normal);
+    octEncode(v.Tangent, p.tangent);
+    p.texCoords[0] = floatToHalf(v.TexCoords.x);
+    p.texCoords[1] = floatToHalf(v.TexCoords.y);
+  }
+}
+
+void unpackVertex(const PackedVertex& packed, const PackedBounds& bounds, Vertex& vertex)
+{
+  vertex.Position = bounds.offset + bounds.scale * glm::vec3(packed.position[0] / UNORM16_MAX,
+                                                             packed.position[1] / UNORM16_MAX,
+                                                             packed.position[2] / UNORM16_MAX);
+  vertex.Normal = octDecode(packed.normal);
+  vertex.Tangent = octDecode(packed.tangent);
+  float handedness = packed.position[3] / UNORM16_MAX * 2.0f - 1.0f;
+  vertex.Bitangent = glm::cross(vertex.Normal, vertex.Tangent) * handedness;
+  vertex.TexCoords = glm::vec2(halfToFloat(packed.texCoords[0]), halfToFloat(packed.texCoords[1]));
+}
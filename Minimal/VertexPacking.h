@@ -0,0 +1,62 @@
+#ifndef VERTEXPACKING_H
+#define VERTEXPACKING_H
+
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+struct Vertex;
+
+// How a Mesh stores its vertices on the GPU
+enum class VertexFormat
+{
+  // Vertex as is, 56 bytes
+  Float,
+  // PackedVertex, 20 bytes; needs the _packed variant of the vertex shader
+  Packed
+};
+
+// A Vertex in 20 bytes:
+//  - position as 16 bit unsigned normalised values across the mesh's bounds
+//    (position = offset + scale * value), with the bitangent's handedness in w
+//  - normal and tangent octahedral-encoded into two 16 bit integers each,
+//    decoded from integers in the shader so the result does not depend on the
+//    GL version's snorm rules
+//  - texture coordinates as half floats
+// The bitangent is rebuilt as cross(normal, tangent) * handedness.
+struct PackedVertex
+{
+  uint16_t position[4];
+  int16_t normal[2];
+  int16_t tangent[2];
+  uint16_t texCoords[2];
+};
+
+// Maps the 16 bit positions back into the mesh's space. The vertex shader
+// gets these as the positionOffset and positionScale uniforms.
+struct PackedBounds
+{
+  glm::vec3 offset;
+  glm::vec3 scale;
+};
+
+// The bounds of the vertices' positions. An axis with no extent gets scale 0.
+PackedBounds packedBounds(const Vertex* vertices, size_t count);
+
+void packVertices(const Vertex* vertices, size_t count, const PackedBounds& bounds, PackedVertex* packed);
+
+// What the vertex shader decodes, for checking the precision on the CPU
+void unpackVertex(const PackedVertex& packed, const PackedBounds& bounds, Vertex& vertex);
+
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t half);
+
+// Unit vector to and from the octahedral encoding, each part scaled to +-32767
+void octEncode(const glm::vec3& v, int16_t encoded[2]);
+glm::vec3 octDecode(const int16_t encoded[2]);
+
+#endif
@@ -0,0 +1,83 @@
+#include "WorkerPool.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned int threadCount) : busy_(0), stopping_(false)
+{
+  threadCount = std::max(1u, threadCount);
+  for (unsigned int i = 0; i < threadCount; i++)
+  {
+    threads_.emplace_back(&WorkerPool::run, this);
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    jobs_.clear();
+  }
+  wake_.notify_all();
+  for (auto& thread : threads_)
+  {
+    thread.join();
+  }
+}
+
+void WorkerPool::submit(std::function<void()> job)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(std::move(job));
+  }
+  wake_.notify_one();
+}
+
+void WorkerPool::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [&] { return jobs_.empty() && busy_ == 0; });
+}
+
+unsigned int WorkerPool::defaultThreadCount()
+{
+  // Leave one core for the GL thread
+  unsigned int cores = std::thread::hardware_concurrency();
+  return cores > 1 ? cores - 1 : 1;
+}
+
+void WorkerPool::run()
+{
+  TraceCapture::instance().setThreadName("worker");
+  for (;;)
+  {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stopping_ || !jobs_.empty(); });
+      if (stopping_)
+      {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+      ++busy_;
+    }
+
+    {
+      TraceZone zone("job", "worker");
+      job();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --busy_;
+      if (jobs_.empty() && busy_ == 0)
+      {
+        idle_.notify_all();
+      }
+    }
+  }
+}
@@ -0,0 +1,45 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads running submitted jobs in FIFO order. Jobs must not
+// touch the GL context; hand their results back to the GL thread instead.
+class WorkerPool
+{
+public:
+  explicit WorkerPool(unsigned int threadCount = defaultThreadCount());
+
+  // Drops jobs that have not started yet and joins the threads.
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  void submit(std::function<void()> job);
+
+  // Blocks until every submitted job has finished.
+  void wait();
+
+  unsigned int size() const { return static_cast<unsigned int>(threads_.size()); }
+
+  static unsigned int defaultThreadCount();
+
+private:
+  void run();
+
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> jobs_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  unsigned int busy_;
+  bool stopping_;
+};
+
+#endif
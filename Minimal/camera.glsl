@@ -0,0 +1,28 @@
+// Shared by every vertex shader: readShaderSources splices this file in right
+// after the shader's #version line. The block must match CameraBlock in
+// CameraUniforms.h.
+
+// The camera is shared by every draw in a pass (see CameraUniforms). Draws are
+// instanced once per eye and gl_InstanceID picks the eye; eyeCount is 1 when
+// the eyes are rendered one at a time.
+layout(std140) uniform Camera {
+    mat4 projection[2];
+    mat4 view[2];
+    mat4 viewProjection[2];
+    vec4 eyeRect[2];
+    int eyeCount;
+};
+
+out float gl_ClipDistance[4];
+
+// Moves a clip-space position into the eye's rect of the viewport and clips it there
+vec4 toEye(vec4 clip, int eye)
+{
+    vec4 rect = eyeRect[eye];
+    vec4 p = vec4(clip.xy * rect.xy + rect.zw * clip.w, clip.zw);
+    gl_ClipDistance[0] = p.x - (rect.z - rect.x) * p.w;
+    gl_ClipDistance[1] = (rect.z + rect.x) * p.w - p.x;
+    gl_ClipDistance[2] = p.y - (rect.w - rect.y) * p.w;
+    gl_ClipDistance[3] = (rect.w + rect.y) * p.w - p.y;
+    return p;
+}
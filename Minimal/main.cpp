@@ -21,8 +21,16 @@ limitations under the License.
 #include <memory>
 #include <exception>
 #include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 #define __STDC_FORMAT_MACROS 1
 
@@ -42,7 +50,19 @@ limitations under the License.
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include "Skybox.h"
-#include "Model.h"
+#include "CubemapLoader.h"
+#include "GlCallCounter.h"
+#include "CameraUniforms.h"
+#include "PoseHistory.h"
+#include "TrackingSampler.h"
+#include "FrameTiming.h"
+#include "HmdBackend.h"
+#include "InputLog.h"
+#include "Scene.h"
+#include "TextureCache.h"
+#include "MeshOptimizer.h"
+#include "Cursor.h"
+#include "shader.h"
 
 // Import the most commonly used types into the default namespace
 using glm::ivec3;
@@ -153,7 +173,12 @@ bool checkGlError()
 void glDebugCallbackHandler(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* msg,
                             GLvoid* data)
 {
+#ifdef _WIN32
   OutputDebugStringA(msg);
+#else
+  fputs(msg, stderr);
+  fputc('\n', stderr);
+#endif
   std::cout << "debug call: " << msg << std::endl;
 }
 
@@ -179,8 +204,49 @@ namespace glfw
     }
     return window;
   }
+
+  // Before glfwInit. Only GLFW 3.4 and later run without any window system:
+  // the null platform with an OSMesa context (libOSMesa is loaded at run
+  // time). Older versions open a hidden window, which needs a display server.
+  inline void headlessInitHints()
+  {
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#elif !defined(_WIN32) && !defined(__APPLE__)
+    if (!getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY"))
+    {
+      FAIL("--headless without a display server needs GLFW 3.4 or later");
+    }
+#endif
+  }
+
+  // The window is never shown and only carries the context
+  inline void headlessWindowHints()
+  {
+    glfwWindowHint(GLFW_VISIBLE, false);
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+    // The only context the null platform has: OSMesa, usually llvmpipe
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
+  }
 }
 
+// Per-stage CPU and GPU times of every frame, summarised in the window with
+// --frame-timing. Written to frameCsvPath with the C key, and at exit with --frame-csv.
+bool frameTimingEnabled = false;
+bool frameCsvAtExit = false;
+std::string frameCsvPath = "frame_timing.csv";
+// Chrome trace capture, started and stopped with the T key or from launch to
+// exit with --trace
+bool traceAtStart = false;
+std::string tracePath = "trace.json";
+// --headless renders without a visible window and presents nothing; the last
+// mirror image can still be written to mirrorDumpPath at exit. maxFrames ends
+// the run after that many frames, 0 runs until the window is closed.
+bool headless = false;
+unsigned int maxFrames = 0;
+std::string mirrorDumpPath;
+
 // A class to encapsulate using GLFW to handle input and render a scene
 class GlfwApp
 {
@@ -189,10 +255,21 @@ protected:
   ivec2 windowPosition;
   GLFWwindow* window{nullptr};
   unsigned int frame{0};
+  std::unique_ptr<FrameTiming> frameTiming;
+
+private:
+  // Frames the window summary averages over, and how often it is refreshed
+  static const size_t FRAME_SUMMARY_FRAMES = 90;
+  static const unsigned int FRAME_SUMMARY_INTERVAL = 45;
+  FrameSummary frameSummary{};
 
 public:
   GlfwApp()
   {
+    if (headless)
+    {
+      glfw::headlessInitHints();
+    }
     // Initialize the GLFW system for creating and positioning windows
     if (!glfwInit())
     {
@@ -226,15 +303,51 @@ public:
 
     initGl();
 
-    while (!glfwWindowShouldClose(window))
+    // The queries never block, so timing is always on; only the display is optional
+    frameTiming = std::make_unique<FrameTiming>();
+    TraceCapture& trace = TraceCapture::instance();
+    trace.setThreadName("render");
+    if (traceAtStart)
+    {
+      trace.start();
+    }
+
+    while (!glfwWindowShouldClose(window) && (maxFrames == 0 || frame < maxFrames))
     {
       ++frame;
-      glfwPollEvents();
-      update();
+      auto frameBegin = std::chrono::steady_clock::now();
+      frameTiming->beginFrame(frame);
+      {
+        FrameStageScope stage(frameTiming.get(), FrameStage::Poll);
+        glfwPollEvents();
+      }
+      {
+        FrameStageScope stage(frameTiming.get(), FrameStage::Update);
+        update();
+      }
       draw();
+      if (frameTimingEnabled)
+      {
+        showFrameTiming();
+      }
       finishFrame();
+      if (trace.capturing())
+      {
+        trace.zone("frame", "frame", frameBegin, std::chrono::steady_clock::now(), "frame", frame);
+      }
     }
 
+    frameTiming->flush();
+    if (frameCsvAtExit)
+    {
+      frameTiming->writeCsv(frameCsvPath);
+    }
+    if (trace.capturing())
+    {
+      trace.stop(tracePath);
+    }
+    frameTiming.reset();
+
     shutdownGl();
 
     return 0;
@@ -252,6 +365,10 @@ protected:
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+    if (headless)
+    {
+      glfw::headlessWindowHints();
+    }
   }
 
   void postCreate()
@@ -292,9 +409,35 @@ protected:
 
   virtual void finishFrame()
   {
+    if (headless)
+    {
+      // Nothing to present, but the frame's commands still have to go out
+      glFlush();
+      return;
+    }
     glfwSwapBuffers(window);
   }
 
+  // Frame time the timing overlay marks as the budget
+  virtual double frameBudgetMs() const
+  {
+    return 1000.0 / 60.0;
+  }
+
+  // Bars over the bottom of the window and the numbers in its title
+  void showFrameTiming()
+  {
+    if (frame % FRAME_SUMMARY_INTERVAL == 0)
+    {
+      frameSummary = frameTiming->summarize(FRAME_SUMMARY_FRAMES);
+      glfwSetWindowTitle(window, formatFrameSummary(frameSummary).c_str());
+    }
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    FrameTiming::drawOverlay(frameSummary, width, height, frameBudgetMs());
+  }
+
   virtual void destroyWindow()
   {
     glfwSetKeyCallback(window, nullptr);
@@ -314,6 +457,10 @@ protected:
     case GLFW_KEY_ESCAPE:
       glfwSetWindowShouldClose(window, 1);
       return;
+
+    case GLFW_KEY_C:
+      frameTiming->writeCsv(frameCsvPath);
+      return;
     }
   }
 
@@ -454,28 +601,25 @@ namespace ovr
   }
 }
 
+// Which HmdBackend drives the app (--hmd rift|mock), and the mock's settings
+#ifdef _WIN32
+std::string hmdBackend = "rift";
+#else
+std::string hmdBackend = "mock";
+#endif
+MockHmdConfig mockHmdConfig;
+
 class RiftManagerApp
 {
 protected:
-  ovrSession _session;
+  std::unique_ptr<HmdBackend> _hmd;
   ovrHmdDesc _hmdDesc;
-  ovrGraphicsLuid _luid;
 
 public:
   RiftManagerApp()
   {
-    if (!OVR_SUCCESS(ovr_Create(&_session, &_luid)))
-    {
-      FAIL("Unable to create HMD session");
-    }
-
-    _hmdDesc = ovr_GetHmdDesc(_session);
-  }
-
-  ~RiftManagerApp()
-  {
-    ovr_Destroy(_session);
-    _session = nullptr;
+    _hmd = createHmdBackend(hmdBackend, mockHmdConfig);
+    _hmdDesc = _hmd->hmdDesc();
   }
 };
 
@@ -490,6 +634,43 @@ int tracking_lag = 0;
 int render_lag = 0;
 bool superRotation = false;
 
+// Load the cubemaps on the GL thread before the first frame (--serial-load)
+bool serialLoad = false;
+// Per-eye CPU time and GL call counts, printed every few hundred frames
+bool glStats = false;
+// Cubes per side of the Scene's grid; 0 keeps the original pair of cubes
+unsigned int gridSize = 0;
+// One glDrawArraysInstanced for all cubes instead of a draw per cube
+bool instancing = true;
+// Both eyes in one pass, each draw instanced once per eye; only for the normal
+// button_A view, the other views use the per-eye passes
+bool singlePassStereo = true;
+// The cursor model in the packed vertex format (VertexPacking.h) instead of full floats
+bool packedVertices = false;
+// What the cursor model's import does to its meshes (MeshOptimizer.h); the bake is redone when this changes
+unsigned int meshOptimization = MESH_OPTIMIZE_DEFAULT;
+const auto startupBegin = std::chrono::steady_clock::now();
+
+// Head and hand poses of the last frames; the lags and delays look back into it
+typedef PoseHistory<1024> TrackingHistory;
+// Samples per second for a tracking thread feeding the history; 0 samples
+// once per frame on the render thread
+double trackingRate = 0.0;
+// Latency injection in milliseconds (--tracking-delay, --render-delay), held
+// constant whatever the frame time by interpolating the pose history. While
+// negative the triggers step tracking_lag and render_lag in frames instead.
+double trackingDelayMs = -1.0;
+double renderDelayMs = -1.0;
+const double DELAY_STEP_MS = 5.0;
+const double MAX_DELAY_MS = 500.0;
+
+// Every frame's input and tracking written to an input log (--record), or
+// read from one in place of the HMD's (--replay), paced like the recording
+// unless --replay-fast. A replay ends the run after its last frame.
+std::string inputRecordPath;
+std::string inputReplayPath;
+bool inputReplayFast = false;
+
 class RiftApp : public GlfwApp, public RiftManagerApp
 {
 public:
@@ -497,10 +678,8 @@ public:
 private:
   GLuint _fbo{0};
   GLuint _depthBuffer{0};
-  ovrTextureSwapChain _eyeTexture;
 
   GLuint _mirrorFbo{0};
-  ovrMirrorTexture _mirrorTexture;
 
   ovrEyeRenderDesc _eyeRenderDescs[2];
 
@@ -522,6 +701,20 @@ private:
   int set_iod = 1;
   int count = 0;
 
+  FrameInput _frameInput{};
+  // One sample per frame, or trackingRate samples per second from the sampler
+  std::unique_ptr<TrackingHistory> _poses;
+  std::unique_ptr<TrackingSampler> _sampler;
+  std::unique_ptr<InputRecorder> _recorder;
+  std::unique_ptr<InputReplay> _replay;
+
+  // --gl-stats totals since the last report, per eye and for single-pass frames
+  static const unsigned int EYE_STATS_FRAMES = 500;
+  static const int STEREO_PASS = 2;
+  double _eyeCpuMs[3]{};
+  GlCallCounts _eyeCalls[3]{};
+  unsigned int _eyeStatsFrames{0};
+
 public:
 
   RiftApp()
@@ -535,18 +728,17 @@ public:
 
     ovr::for_each_eye([&](ovrEyeType eye)
     {
-      ovrEyeRenderDesc& erd = _eyeRenderDescs[eye] = ovr_GetRenderDesc(_session, eye, _hmdDesc.DefaultEyeFov[eye]);
-      ovrMatrix4f ovrPerspectiveProjection =
-        ovrMatrix4f_Projection(erd.Fov, 0.01f, 1000.0f, ovrProjection_ClipRangeOpenGL);
+      ovrEyeRenderDesc& erd = _eyeRenderDescs[eye] = _hmd->renderDesc(eye, _hmdDesc.DefaultEyeFov[eye]);
+      ovrMatrix4f ovrPerspectiveProjection = _hmd->projection(erd.Fov, 0.01f, 1000.0f);
       _eyeProjections[eye] = ovr::toGlm(ovrPerspectiveProjection);
       _viewScaleDesc.HmdToEyePose[eye] = erd.HmdToEyePose;
 
 	  //set iod
-	  iod = abs(_viewScaleDesc.HmdToEyePose[0].Position.x - _viewScaleDesc.HmdToEyePose[1].Position.x);
-	  iod_origin = abs(_viewScaleDesc.HmdToEyePose[0].Position.x - _viewScaleDesc.HmdToEyePose[1].Position.x);
+	  iod = std::abs(_viewScaleDesc.HmdToEyePose[0].Position.x - _viewScaleDesc.HmdToEyePose[1].Position.x);
+	  iod_origin = std::abs(_viewScaleDesc.HmdToEyePose[0].Position.x - _viewScaleDesc.HmdToEyePose[1].Position.x);
 
       ovrFovPort& fov = _sceneLayer.Fov[eye] = _eyeRenderDescs[eye].Fov;
-      auto eyeSize = ovr_GetFovTextureSize(_session, eye, fov, 1.0f);
+      auto eyeSize = _hmd->fovTextureSize(eye, fov, 1.0f);
       _sceneLayer.Viewport[eye].Size = eyeSize;
       _sceneLayer.Viewport[eye].Pos = {(int)_renderTargetSize.x, 0};
 
@@ -556,6 +748,40 @@ public:
     // Make the on screen window 1/4 the resolution of the render target
     _mirrorSize = _renderTargetSize;
     _mirrorSize /= 4;
+
+    if (!inputReplayPath.empty())
+    {
+      _replay = std::make_unique<InputReplay>(inputReplayPath, !inputReplayFast);
+    }
+    if (!inputRecordPath.empty())
+    {
+      _recorder = std::make_unique<InputRecorder>(inputRecordPath);
+    }
+
+    _poses = std::make_unique<TrackingHistory>();
+    // A replay only has the poses of each frame
+    if (trackingRate > 0.0 && _replay)
+    {
+      printf("Tracking sampler is off while replaying an input log\n");
+    }
+    else if (trackingRate > 0.0)
+    {
+      _sampler = std::make_unique<TrackingSampler>(*_hmd, trackingRate, [this](const PoseSample& sample)
+      {
+        _poses->push(sample);
+      });
+      _sampler->start();
+    }
+  }
+
+  ~RiftApp()
+  {
+    // Before the session goes
+    if (_sampler)
+    {
+      _sampler->stop();
+      _sampler->printStats();
+    }
   }
 
 protected:
@@ -564,6 +790,11 @@ protected:
     return glfw::createWindow(_mirrorSize);
   }
 
+  double frameBudgetMs() const override
+  {
+    return 1000.0 / _hmdDesc.DisplayRefreshRate;
+  }
+
   void initGl() override
   {
     GlfwApp::initGl();
@@ -571,32 +802,11 @@ protected:
     // Disable the v-sync for buffer swap
     glfwSwapInterval(0);
 
-    ovrTextureSwapChainDesc desc = {};
-    desc.Type = ovrTexture_2D;
-    desc.ArraySize = 1;
-    desc.Width = _renderTargetSize.x;
-    desc.Height = _renderTargetSize.y;
-    desc.MipLevels = 1;
-    desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
-    desc.SampleCount = 1;
-    desc.StaticImage = ovrFalse;
-    ovrResult result = ovr_CreateTextureSwapChainGL(_session, &desc, &_eyeTexture);
-    _sceneLayer.ColorTexture[0] = _eyeTexture;
-    if (!OVR_SUCCESS(result))
-    {
-      FAIL("Failed to create swap textures");
-    }
-
-    int length = 0;
-    result = ovr_GetTextureSwapChainLength(_session, _eyeTexture, &length);
-    if (!OVR_SUCCESS(result) || !length)
-    {
-      FAIL("Unable to count swap chain textures");
-    }
+    _hmd->createSwapChain(_renderTargetSize.x, _renderTargetSize.y);
+    int length = _hmd->swapChainLength();
     for (int i = 0; i < length; ++i)
     {
-      GLuint chainTexId;
-      ovr_GetTextureSwapChainBufferGL(_session, _eyeTexture, i, &chainTexId);
+      GLuint chainTexId = _hmd->swapChainTexture(i);
       glBindTexture(GL_TEXTURE_2D, chainTexId);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -615,16 +825,41 @@ protected:
     glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
-    ovrMirrorTextureDesc mirrorDesc;
-    memset(&mirrorDesc, 0, sizeof(mirrorDesc));
-    mirrorDesc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
-    mirrorDesc.Width = _mirrorSize.x;
-    mirrorDesc.Height = _mirrorSize.y;
-    if (!OVR_SUCCESS(ovr_CreateMirrorTextureGL(_session, &mirrorDesc, &_mirrorTexture)))
+    _hmd->createMirrorTexture(_mirrorSize.x, _mirrorSize.y);
+    glGenFramebuffers(1, &_mirrorFbo);
+  }
+
+  void shutdownGl() override
+  {
+    if (!mirrorDumpPath.empty())
     {
-      FAIL("Could not create mirror texture");
+      writeMirror(mirrorDumpPath);
     }
-    glGenFramebuffers(1, &_mirrorFbo);
+    GlfwApp::shutdownGl();
+  }
+
+  // The mirror texture as a binary PPM. Its rows are already top first.
+  bool writeMirror(const std::string& path)
+  {
+    std::vector<unsigned char> pixels(_mirrorSize.x * _mirrorSize.y * 3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _mirrorFbo);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _hmd->mirrorTexture(), 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, _mirrorSize.x, _mirrorSize.y, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+      printf("Unable to write the mirror image to %s\n", path.c_str());
+      return false;
+    }
+    fprintf(file, "P6\n%u %u\n255\n", _mirrorSize.x, _mirrorSize.y);
+    fwrite(pixels.data(), 1, pixels.size(), file);
+    fclose(file);
+    printf("Mirror image (frame %u) written to %s\n", frame, path.c_str());
+    return true;
   }
 
   void onKey(int key, int scancode, int action, int mods) override
@@ -633,16 +868,62 @@ protected:
       switch (key)
       {
       case GLFW_KEY_R:
-        ovr_RecenterTrackingOrigin(_session);
+        _hmd->recenter();
+        return;
+
+      case GLFW_KEY_T:
+        // The GPU zones of the last frames, still in flight, are left out
+        if (TraceCapture::instance().capturing())
+        {
+          TraceCapture::instance().stop(tracePath);
+        }
+        else
+        {
+          TraceCapture::instance().start();
+        }
         return;
       }
 
     GlfwApp::onKey(key, scancode, action, mods);
   }
 
+  // The one tracking and input query of the frame, or the next frame of the replay
+  void sampleFrameInput()
+  {
+    _frameInput.frame = frame;
+    if (_replay)
+    {
+      // Past the end the last frame's input is kept
+      _replay->next(_frameInput);
+      if (_replay->finished())
+      {
+        glfwSetWindowShouldClose(window, 1);
+      }
+    }
+    else
+    {
+      _frameInput.displayTime = _hmd->predictedDisplayTime(frame);
+      _frameInput.sensorSampleTime = _hmd->timeInSeconds();
+      _frameInput.tracking = _hmd->trackingState(_frameInput.displayTime, true);
+      _frameInput.hasInput = _hmd->inputState(_frameInput.input);
+    }
+    if (_recorder)
+    {
+      _recorder->record(_frameInput);
+    }
+  }
+
   void update() final override {
-	  ovrInputState inputState;
-	  if (OVR_SUCCESS(ovr_GetInputState(_session, ovrControllerType_Touch, &inputState))) {
+	  sampleFrameInput();
+	  if (_sampler) {
+		  _sampler->setFrame(frame);
+	  }
+	  else {
+		  _poses->push(_frameInput.poses());
+	  }
+
+	  const ovrInputState& inputState = _frameInput.input;
+	  if (_frameInput.hasInput) {
 
 		  //Triggers
 		  if (inputState.IndexTrigger[ovrHand_Left] < 0.01f && inputState.IndexTrigger[ovrHand_Right] < 0.01f
@@ -650,28 +931,60 @@ protected:
 			  isTouched = false;
 		  }
 
-		  if (inputState.IndexTrigger[ovrHand_Left] > 0.1f && tracking_lag > 0 && !isTouched) {
-			  isTouched = true;
-			  tracking_lag--;
-			  printf("Tracking lag: %d frames\n", tracking_lag);
+		  if (trackingDelayMs >= 0.0) {
+			  if (inputState.IndexTrigger[ovrHand_Left] > 0.1f && trackingDelayMs > 0.0 && !isTouched) {
+				  isTouched = true;
+				  trackingDelayMs = std::max(0.0, trackingDelayMs - DELAY_STEP_MS);
+				  printf("Tracking delay: %.0f ms\n", trackingDelayMs);
+			  }
+
+			  if (inputState.IndexTrigger[ovrHand_Right] > 0.1f && trackingDelayMs < MAX_DELAY_MS && !isTouched) {
+				  isTouched = true;
+				  trackingDelayMs = std::min(MAX_DELAY_MS, trackingDelayMs + DELAY_STEP_MS);
+				  printf("Tracking delay: %.0f ms\n", trackingDelayMs);
+			  }
 		  }
 
-		  if (inputState.IndexTrigger[ovrHand_Right] > 0.1f && tracking_lag < 29 && !isTouched) {
-			  isTouched = true;
-			  tracking_lag++;
-			  printf("Tracking lag: %d frames\n", tracking_lag);
+		  else {
+			  if (inputState.IndexTrigger[ovrHand_Left] > 0.1f && tracking_lag > 0 && !isTouched) {
+				  isTouched = true;
+				  tracking_lag--;
+				  printf("Tracking lag: %d frames\n", tracking_lag);
+			  }
+
+			  if (inputState.IndexTrigger[ovrHand_Right] > 0.1f && tracking_lag < (int)TrackingHistory::MAX_OFFSET && !isTouched) {
+				  isTouched = true;
+				  tracking_lag++;
+				  printf("Tracking lag: %d frames\n", tracking_lag);
+			  }
 		  }
 
-		  if (inputState.HandTrigger[ovrHand_Left] > 0.1f && render_lag > 0 && !isTouched) {
-			  isTouched = true;
-			  render_lag--;
-			  printf("Rendering delay: %d frames\n", render_lag);
+		  if (renderDelayMs >= 0.0) {
+			  if (inputState.HandTrigger[ovrHand_Left] > 0.1f && renderDelayMs > 0.0 && !isTouched) {
+				  isTouched = true;
+				  renderDelayMs = std::max(0.0, renderDelayMs - DELAY_STEP_MS);
+				  printf("Rendering delay: %.0f ms\n", renderDelayMs);
+			  }
+
+			  if (inputState.HandTrigger[ovrHand_Right] > 0.1f && renderDelayMs < MAX_DELAY_MS && !isTouched) {
+				  isTouched = true;
+				  renderDelayMs = std::min(MAX_DELAY_MS, renderDelayMs + DELAY_STEP_MS);
+				  printf("Rendering delay: %.0f ms\n", renderDelayMs);
+			  }
 		  }
 
-		  if (inputState.HandTrigger[ovrHand_Right] > 0.1f && render_lag < 10 && !isTouched) {
-			  isTouched = true;
-			  render_lag++;
-			  printf("Rendering delay: %d frames\n", render_lag);
+		  else {
+			  if (inputState.HandTrigger[ovrHand_Left] > 0.1f && render_lag > 0 && !isTouched) {
+				  isTouched = true;
+				  render_lag--;
+				  printf("Rendering delay: %d frames\n", render_lag);
+			  }
+
+			  if (inputState.HandTrigger[ovrHand_Right] > 0.1f && render_lag < 10 && !isTouched) {
+				  isTouched = true;
+				  render_lag++;
+				  printf("Rendering delay: %d frames\n", render_lag);
+			  }
 		  }
 
 		  //update iod
@@ -769,10 +1082,30 @@ protected:
 
   void draw() final override
   {
+    beginFrame(_frameInput);
+
+    // The head pose was sampled in update(); only the eye offsets are applied here
     ovrPosef eyePoses[2];
-    ovr_GetEyePoses(_session, frame, true, _viewScaleDesc.HmdToEyePose, eyePoses, &_sceneLayer.SensorSampleTime);
+    _hmd->calcEyePoses(_frameInput.tracking.HeadPose.ThePose, _viewScaleDesc.HmdToEyePose, eyePoses);
+    _sceneLayer.SensorSampleTime = _frameInput.sensorSampleTime;
+    if (TraceCapture::instance().capturing())
+    {
+      TraceCapture::instance().instant("SensorSampleTime", "frame", std::chrono::steady_clock::now(), "frame", frame,
+                                       "seconds", _frameInput.sensorSampleTime);
+    }
 
-	if (count == 0) {
+	if (renderDelayMs >= 0.0) {
+		// Render from the head as it was renderDelayMs ago. RenderPose below stays
+		// the current pose, so timewarp does not take the delay back out.
+		PoseSample delayed;
+		ovrPosef head = posesDelayedBy(renderDelayMs / 1000.0, delayed) ? delayed.head.ThePose
+		                                                                 : _frameInput.tracking.HeadPose.ThePose;
+		ovrPosef delayedEyes[2];
+		_hmd->calcEyePoses(head, _viewScaleDesc.HmdToEyePose, delayedEyes);
+		left_pos_new = ovr::toGlm(delayedEyes[ovrEye_Left]);
+		right_pos_new = ovr::toGlm(delayedEyes[ovrEye_Right]);
+	}
+	else if (count == 0) {
 		left_pos_new = ovr::toGlm(eyePoses[ovrEye_Left]);
 		right_pos_new = ovr::toGlm(eyePoses[ovrEye_Right]);
 		projection_old[0] = _eyeProjections[0];
@@ -805,18 +1138,62 @@ protected:
 		right_pos_new = right_pos_old;
 	}
 
-    int curIndex;
-    ovr_GetTextureSwapChainCurrentIndex(_session, _eyeTexture, &curIndex);
-    GLuint curTexId;
-    ovr_GetTextureSwapChainBufferGL(_session, _eyeTexture, curIndex, &curTexId);
+    GLuint curTexId = _hmd->swapChainTexture(_hmd->swapChainCurrentIndex());
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo);
     glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, curTexId, 0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (singlePassStereo && button_A == 1)
+    {
+      renderStereoPass(eyePoses);
+    }
+    else
+    {
+      renderEyePasses(eyePoses);
+    }
+    if (glStats && ++_eyeStatsFrames == EYE_STATS_FRAMES)
+    {
+      reportEyeStats();
+    }
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    {
+      FrameStageScope stage(frameTiming.get(), FrameStage::Commit);
+      _hmd->commitSwapChain();
+    }
+    {
+      FrameStageScope stage(frameTiming.get(), FrameStage::Submit);
+      _hmd->submitFrame(frame, _viewScaleDesc, _sceneLayer);
+    }
+    endFrame();
+
+    // Headless, the mirror texture is only read back at exit
+    if (!headless)
+    {
+      FrameStageScope stage(frameTiming.get(), FrameStage::Mirror);
+      GLuint mirrorTextureId = _hmd->mirrorTexture();
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, _mirrorFbo);
+      glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mirrorTextureId, 0);
+      glBlitFramebuffer(0, 0, _mirrorSize.x, _mirrorSize.y, 0, _mirrorSize.y, _mirrorSize.x, 0, GL_COLOR_BUFFER_BIT,
+                        GL_NEAREST);
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+
+	//update position
+	left_pos_old = left_pos_new;
+	right_pos_old = right_pos_new;
+  }
+
+  // One pass per eye into its own viewport, for every button_A view
+  void renderEyePasses(const ovrPosef eyePoses[2])
+  {
     ovr::for_each_eye([&](ovrEyeType eye)
     {
       const auto& vp = _sceneLayer.Viewport[eye];
-      glViewport(vp.Pos.x, vp.Pos.y, vp.Size.w, vp.Size.h);
+      glCounted::Viewport(vp.Pos.x, vp.Pos.y, vp.Size.w, vp.Size.h);
       _sceneLayer.RenderPose[eye] = eyePoses[eye];
+      FrameStageScope stage(frameTiming.get(), eye == ovrEye_Left ? FrameStage::LeftEye : FrameStage::RightEye);
+      auto eyeBegin = std::chrono::steady_clock::now();
+      GlCallCounts eyeCallsBegin = glCallCounts();
 
 	  if (button_A == 1) {
 		if (eye == ovrEye_Left) {
@@ -854,54 +1231,104 @@ protected:
 		  }
 	  }
 
+      if (glStats)
+      {
+        _eyeCpuMs[eye] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - eyeBegin).count();
+        _eyeCalls[eye] = _eyeCalls[eye] + (glCallCounts() - eyeCallsBegin);
+      }
     });
-    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-    ovr_CommitTextureSwapChain(_session, _eyeTexture);
-    ovrLayerHeader* headerList = &_sceneLayer.Header;
-    ovr_SubmitFrame(_session, frame, &_viewScaleDesc, &headerList, 1);
+  }
 
-    GLuint mirrorTextureId;
-    ovr_GetMirrorTextureBufferGL(_session, _mirrorTexture, &mirrorTextureId);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, _mirrorFbo);
-    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mirrorTextureId, 0);
-    glBlitFramebuffer(0, 0, _mirrorSize.x, _mirrorSize.y, 0, _mirrorSize.y, _mirrorSize.x, 0, GL_COLOR_BUFFER_BIT,
-                      GL_NEAREST);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  // Both eyes into a viewport covering the whole target. The shaders move each
+  // eye's instances into its own viewport and clip them there.
+  void renderStereoPass(const ovrPosef eyePoses[2])
+  {
+    FrameStageScope stage(frameTiming.get(), FrameStage::BothEyes);
+    auto passBegin = std::chrono::steady_clock::now();
+    GlCallCounts passCallsBegin = glCallCounts();
 
-	//update position
-	left_pos_old = left_pos_new;
-	right_pos_old = right_pos_new;
-  }
+    glm::vec4 eyeRects[2];
+    ovr::for_each_eye([&](ovrEyeType eye)
+    {
+      const auto& vp = _sceneLayer.Viewport[eye];
+      eyeRects[eye] = CameraUniforms::viewportRect(vp.Pos.x, vp.Pos.y, vp.Size.w, vp.Size.h, _renderTargetSize.x,
+                                                   _renderTargetSize.y);
+      _sceneLayer.RenderPose[eye] = eyePoses[eye];
+    });
+    glCounted::Viewport(0, 0, _renderTargetSize.x, _renderTargetSize.y);
+    for (int plane = 0; plane < CameraUniforms::CLIP_PLANES; plane++)
+    {
+      glCounted::Enable(GL_CLIP_DISTANCE0 + plane);
+    }
 
-  virtual void renderScene(const glm::mat4& projection, const glm::mat4& headPose, bool isLeft) = 0;
-};
+    const mat4 headPoses[2] = { left_pos_new, right_pos_new };
+    renderSceneStereo(_eyeProjections, headPoses, eyeRects);
 
-class Cursor {
+    for (int plane = 0; plane < CameraUniforms::CLIP_PLANES; plane++)
+    {
+      glCounted::Disable(GL_CLIP_DISTANCE0 + plane);
+    }
 
-	// Shader ID
-	GLuint shaderID;
+    if (glStats)
+    {
+      _eyeCpuMs[STEREO_PASS] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - passBegin).count();
+      _eyeCalls[STEREO_PASS] = _eyeCalls[STEREO_PASS] + (glCallCounts() - passCallsBegin);
+    }
+  }
 
-	// Cursor
-	std::unique_ptr<Model> cursor;
+  void reportEyeStats()
+  {
+    static const char* const names[] = { "Left eye", "Right eye", "Both eyes (single pass)" };
+    for (int pass = 0; pass < 3; pass++)
+    {
+      // Skip whichever path did not run this time
+      if (_eyeCalls[pass].total() == 0 && _eyeCpuMs[pass] == 0)
+      {
+        continue;
+      }
+      printf("%s: %.3f ms CPU per frame, GL calls per frame:\n", names[pass], _eyeCpuMs[pass] / _eyeStatsFrames);
+      printGlCallCounts(_eyeCalls[pass], _eyeStatsFrames);
+      _eyeCpuMs[pass] = 0;
+      _eyeCalls[pass] = GlCallCounts{};
+    }
+    _eyeStatsFrames = 0;
+  }
 
-	// User's Dominant Hand's Controller Position 
-	vec3 position;
+  // The tracked poses delaySeconds before this frame's, interpolated
+  bool posesDelayedBy(double delaySeconds, PoseSample& sample) const
+  {
+    // Samples taken per frame are predicted for the display time; the
+    // sampler's are measured as they are taken
+    double latest = _sampler ? _frameInput.sensorSampleTime : _frameInput.tracking.HeadPose.TimeInSeconds;
+    return _poses->atTime(latest - delaySeconds, sample);
+  }
 
+  // The tracked poses frames frames before this frame's
+  bool posesDelayedByFrames(int frames, PoseSample& sample) const
+  {
+    if (_sampler)
+    {
+      // Many samples per frame
+      return posesDelayedBy(frames / _hmdDesc.DisplayRefreshRate, sample);
+    }
+    return _poses->atOffset(frames, sample);
+  }
 
-public:
-	Cursor() {
-		shaderID = LoadShaders("shader_cursor.vert", "shader_cursor.frag");
-		cursor = std::make_unique<Model>("webtrcc.obj");
-	}
+  // Called on the GL thread before the eyes are rendered and after the frame is
+  // submitted. input is this frame's snapshot, also what the eyes are rendered from.
+  virtual void beginFrame(const FrameInput& input)
+  {
+  }
 
-	/* Render sphere at User's Dominant Hand's Controller Position */
-	void render(const glm::mat4& projection, const glm::mat4& view, vec3 pos) {
-		position = pos;
-		glm::mat4 toWorld = glm::translate(glm::mat4(1.0f), position) * glm::scale(glm::mat4(1.0f), glm::vec3(0.02f));
-		cursor->Draw(shaderID, projection, view, toWorld);
-	}
+  virtual void endFrame()
+  {
+  }
 
+  virtual void renderScene(const glm::mat4& projection, const glm::mat4& headPose, bool isLeft) = 0;
+
+  // Both eyes at once; eyeRects place each eye in the viewport (see CameraUniforms)
+  virtual void renderSceneStereo(const glm::mat4 projections[2], const glm::mat4 headPoses[2],
+                                 const glm::vec4 eyeRects[2]) = 0;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -911,132 +1338,6 @@ public:
 // application would perform whatever rendering you want
 //
 
-#include <vector>
-#include "shader.h"
-#include "Cube.h"
-
-// a class for building and rendering cubes
-class Scene
-{
-  // Program
-  std::vector<glm::mat4> instance_positions;
-  GLuint instanceCount;
-  GLuint shaderID;
-
-  std::unique_ptr<TexturedCube> cube;
-  std::unique_ptr<Skybox> skybox_left;
-  std::unique_ptr<Skybox> skybox_right;
-  std::unique_ptr<Skybox> skybox_custom;
-
-  const unsigned int GRID_SIZE{5};
-
-  glm::mat4 cubeSize;
-
-public:
-  Scene()
-  {
-    // Create two cube
-    instance_positions.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, -0.3)));
-    instance_positions.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, -0.9)));
-
-    instanceCount = instance_positions.size();
-
-    // Shader Program 
-    shaderID = LoadShaders("skybox.vert", "skybox.frag");
-
-    cube = std::make_unique<TexturedCube>("cube"); 
-
-	  // 10m wide sky box: size doesn't matter though
-    skybox_left = std::make_unique<Skybox>("skybox_left");
-	skybox_right = std::make_unique<Skybox>("skybox_right");
-	skybox_left ->toWorld = glm::scale(glm::mat4(1.0f), glm::vec3(5.0f));
-	skybox_right->toWorld = glm::scale(glm::mat4(1.0f), glm::vec3(5.0f));
-
-	cubeSize = glm::scale(glm::mat4(1.0f), glm::vec3(0.1f));
-
-	skybox_custom = std::make_unique<Skybox>("skybox_custom");
-	skybox_custom->toWorld = glm::scale(glm::mat4(1.0f), glm::vec3(5.0f));
-  }
-
-  void render(const glm::mat4& projection, const glm::mat4& view, bool isLeft)
-  {
-	  //Change the size of cubes
-	  if (set_Cubesize == 2 && cubeSize[0][0] > 0.01f) {
-		  cubeSize = cubeSize * glm::scale(glm::mat4(1.0f), glm::vec3(0.99f));
-	  }
-
-	  if (set_Cubesize == 3 && cubeSize[0][0] < 0.5f) {
-		  cubeSize = cubeSize * glm::scale(glm::mat4(1.0f), glm::vec3(1.01f));
-	  }
-
-	  if (set_Cubesize == 4) {
-		  cubeSize = glm::scale(glm::mat4(1.0f), glm::vec3(0.1f));
-	  }
-
-    // Render two cubes
-	if (button_X == 1) {
-		for (int i = 0; i < instanceCount; i++)
-			{
-			  // Scale to 20cm: 200cm * 0.1
-			  cube->toWorld = instance_positions[i] * cubeSize;
-			  cube->draw(shaderID, projection, view);
-			}
-	}
-    
-	if (button_X == 1 || button_X == 2) {
-		// Render Skybox : remove view translation
-			if (isLeft) {
-				skybox_left->draw(shaderID, projection, view);
-			}
-			else {
-				skybox_right->draw(shaderID, projection, view);
-			}
-	}
-    
-	else if (button_X == 3) {
-		skybox_left->draw(shaderID, projection, view);
-	}
-
-	else if (button_X == 4) {
-		skybox_custom->draw(shaderID, projection, view);
-	}
-  }
-};
-
-//Ring buffer
-class Buffer {
-	vec3 positions[30];
-	int read, write, num;
-
-public:
-	Buffer() {
-		read = 0;
-		write = 0;
-		num = 0;
-	}
-
-	void push(vec3 position) {
-		positions[write] = position;
-		write = (write + 1) % 30;
-		if (num < 30) {
-			num++;
-		}
-	}
-
-	vec3 pop(int lag) {
-		if (num == 30) {
-			int i = (read - lag + 30) % 30;
-			read = (read + 1) % 30;
-			return positions[i];
-		}
-		
-		else {
-			return positions[0];
-		}
-	}
-
-};
-
 mat3 computeRotation(float theta_x, float theta_y, float theta_z) {
 	mat3 X(1.0f, 0.0f, 0.0f, 0.0f, cosf(theta_x), -sinf(theta_x), 0.0f, sinf(theta_x), cosf(theta_x));
 	mat3 Y(cosf(theta_y), 0.0f, sinf(theta_y), 0.0f, 1.0f, 0.0f, -sinf(theta_y), 0.0f, cosf(theta_y));
@@ -1049,18 +1350,14 @@ mat3 computeRotation(float theta_x, float theta_y, float theta_z) {
 // An example application that renders a simple cube
 class ExampleApp : public RiftApp
 {
+  std::unique_ptr<CameraUniforms> camera;
   std::shared_ptr<Scene> scene;
   std::shared_ptr<Cursor> cursor;
 
-  double displayMidpointSeconds;
-  ovrTrackingState trackState;
-  ovrInputState  inputState;
-  unsigned int handStatus[2];
-  ovrPosef handPoses[2];
-  ovrVector3f handPosition[2];
-  
-  vector<vec3> positions;
-  std::shared_ptr<Buffer> buffer;
+  // The dominant hand tracking_lag frames or trackingDelayMs ago, drawn by both eyes
+  vec3 cursorPosition{0.0f};
+
+  bool startupReported{false};
 
 public:
   ExampleApp()
@@ -1073,35 +1370,69 @@ protected:
     RiftApp::initGl();
     glClearColor(0.2f, 0.2f, 0.2f, 0.0f);
     glEnable(GL_DEPTH_TEST);
-    ovr_RecenterTrackingOrigin(_session);
-    scene = std::shared_ptr<Scene>(new Scene());
-	cursor = std::shared_ptr<Cursor>(new Cursor());
-	buffer = std::shared_ptr<Buffer>(new Buffer());
+    _hmd->recenter();
+    if (glStats)
+    {
+      installGlCallCounter();
+    }
+    camera = std::make_unique<CameraUniforms>();
+    scene = std::shared_ptr<Scene>(new Scene(serialLoad, gridSize));
+    scene->instancing = instancing;
+	cursor = std::shared_ptr<Cursor>(new Cursor("webtrcc.obj", packedVertices, meshOptimization));
+    printShaderCacheStats();
   }
 
   void shutdownGl() override
   {
+    RiftApp::shutdownGl();
+    ShaderLibrary::instance().printStats();
     scene.reset();
+    cursor.reset();
+    camera.reset();
+    TextureCache::instance().printStats();
+    TextureCache::instance().clear();
+    ShaderLibrary::instance().clear();
   }
 
-  void renderScene(const glm::mat4& projection, const glm::mat4& headPose, bool isLeft) override
+  void beginFrame(const FrameInput& input) override
   {
-	displayMidpointSeconds = ovr_GetPredictedDisplayTime(_session, 0);
-	trackState = ovr_GetTrackingState(_session, displayMidpointSeconds, ovrTrue);
-	handStatus[0] = trackState.HandStatusFlags[0];
-	handStatus[1] = trackState.HandStatusFlags[1];
-	handPoses[0] = trackState.HandPoses[0].ThePose;
-	handPoses[1] = trackState.HandPoses[1].ThePose;
-	handPosition[0] = handPoses[0].Position;
-	handPosition[1] = handPoses[1].Position;
+    scene->pumpUploads();
+    scene->view = button_X;
+    scene->sizeStep = set_Cubesize;
+    PoseSample delayed;
+    bool found = trackingDelayMs >= 0.0 ? posesDelayedBy(trackingDelayMs / 1000.0, delayed)
+                                        : posesDelayedByFrames(tracking_lag, delayed);
+    if (found)
+    {
+      cursorPosition = ovr::toGlm(delayed.hands[ovrHand_Right].ThePose.Position);
+    }
+  }
 
-	buffer->push(vec3(handPosition[ovrHand_Right].x, handPosition[ovrHand_Right].y, handPosition[ovrHand_Right].z));
+  // Startup timing report, to compare the background loader against --serial-load
+  void endFrame() override
+  {
+    if (startupReported)
+    {
+      return;
+    }
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin).count();
+    if (frame == 1)
+    {
+      printf("Startup (%s): first frame submitted after %.1f ms\n", serialLoad ? "serial" : "async", elapsed);
+    }
+    if (scene->resident())
+    {
+      printf("Startup (%s): all cubemaps resident after %.1f ms (%u frames)\n", serialLoad ? "serial" : "async",
+             elapsed, frame);
+      startupReported = true;
+    }
+  }
 
+  glm::mat4 viewFor(const glm::mat4& headPose)
+  {
 	if (!superRotation) {
-		scene->render(projection, glm::inverse(headPose), isLeft);
-		cursor->render(projection, glm::inverse(headPose), buffer->pop(tracking_lag));
+		return glm::inverse(headPose);
 	}
-    
 	else {
 		mat3 R(headPose[0], headPose[1], headPose[2]);
 		float theta_1 = atan2f(R[1][2], R[2][2]);
@@ -1113,10 +1444,27 @@ protected:
 		mat4 new_headPose = mat4(new_R);
 		new_headPose[3] = headPose[3];
 
-		scene->render(projection, glm::inverse(new_headPose), isLeft);
-		cursor->render(projection, glm::inverse(new_headPose), buffer->pop(tracking_lag));
+		return glm::inverse(new_headPose);
 	}
   }
+
+  void renderScene(const glm::mat4& projection, const glm::mat4& headPose, bool isLeft) override
+  {
+	// One camera upload per eye, shared by every draw below
+	camera->update(projection, viewFor(headPose));
+	scene->render(isLeft ? ovrEye_Left : ovrEye_Right);
+	cursor->render(cursorPosition);
+  }
+
+  void renderSceneStereo(const glm::mat4 projections[2], const glm::mat4 headPoses[2],
+                         const glm::vec4 eyeRects[2]) override
+  {
+	// One camera upload for both eyes
+	const glm::mat4 views[2] = { viewFor(headPoses[ovrEye_Left]), viewFor(headPoses[ovrEye_Right]) };
+	camera->updateStereo(projections, views, eyeRects);
+	scene->render(Scene::BOTH_EYES);
+	cursor->render(cursorPosition);
+  }
 };
 
 // Execute our example class
@@ -1124,12 +1472,166 @@ int main(int argc, char** argv)
 {
   int result = -1;
 
-  if (!OVR_SUCCESS(ovr_Initialize(nullptr)))
+  for (int i = 1; i < argc; i++)
+  {
+    if (std::string(argv[i]) == "--serial-load")
+    {
+      serialLoad = true;
+    }
+    else if (std::string(argv[i]) == "--packed-vertices")
+    {
+      packedVertices = true;
+    }
+    // Keep the triangles and vertices in the order the importer produced them
+    else if (std::string(argv[i]) == "--no-mesh-optimization")
+    {
+      meshOptimization = MESH_OPTIMIZE_NONE;
+    }
+    // Also sort the cursor's triangles to cut overdraw, at a small cost in vertex cache hits
+    else if (std::string(argv[i]) == "--optimize-overdraw")
+    {
+      meshOptimization |= MESH_OPTIMIZE_OVERDRAW;
+    }
+    // Cold start: compile every program from source (the cache is still refreshed)
+    else if (std::string(argv[i]) == "--no-shader-cache")
+    {
+      setShaderCacheEnabled(false);
+    }
+    // Per-eye CPU time and GL call counts; add --uncached-uniforms for the old per-draw lookups
+    else if (std::string(argv[i]) == "--gl-stats")
+    {
+      glStats = true;
+    }
+    else if (std::string(argv[i]) == "--uncached-uniforms")
+    {
+      UniformLocations::setLookupEveryDraw(true);
+    }
+    // --grid 22 gives 10648 cubes
+    else if (std::string(argv[i]) == "--grid" && i + 1 < argc)
+    {
+      gridSize = static_cast<unsigned int>(atoi(argv[++i]));
+    }
+    else if (std::string(argv[i]) == "--no-instancing")
+    {
+      instancing = false;
+    }
+    // Render the eyes in separate passes, as before single-pass stereo
+    else if (std::string(argv[i]) == "--no-single-pass")
+    {
+      singlePassStereo = false;
+    }
+    // --tracking-rate 1000 samples head and hands on a thread at 1 kHz
+    else if (std::string(argv[i]) == "--tracking-rate" && i + 1 < argc)
+    {
+      trackingRate = atof(argv[++i]);
+    }
+    // Delays in milliseconds, stepped by DELAY_STEP_MS with the triggers
+    else if (std::string(argv[i]) == "--tracking-delay" && i + 1 < argc)
+    {
+      trackingDelayMs = std::min(MAX_DELAY_MS, std::max(0.0, atof(argv[++i])));
+    }
+    else if (std::string(argv[i]) == "--render-delay" && i + 1 < argc)
+    {
+      renderDelayMs = std::min(MAX_DELAY_MS, std::max(0.0, atof(argv[++i])));
+    }
+    // Stage timings in the mirror window; C writes the last HISTORY frames as CSV
+    // at any time
+    else if (std::string(argv[i]) == "--frame-timing")
+    {
+      frameTimingEnabled = true;
+    }
+    // The CSV is also written at exit
+    else if (std::string(argv[i]) == "--frame-csv" && i + 1 < argc)
+    {
+      frameCsvAtExit = true;
+      frameCsvPath = argv[++i];
+    }
+    // --hmd mock renders for a software headset; the --mock-* options set it up
+    else if (std::string(argv[i]) == "--hmd" && i + 1 < argc)
+    {
+      hmdBackend = argv[++i];
+    }
+    else if (std::string(argv[i]) == "--mock-fov" && i + 1 < argc)
+    {
+      mockHmdConfig.fovDegrees = static_cast<float>(atof(argv[++i]));
+    }
+    // Per eye, e.g. --mock-resolution 1344x1600
+    else if (std::string(argv[i]) == "--mock-resolution" && i + 1 < argc)
+    {
+      sscanf(argv[++i], "%dx%d", &mockHmdConfig.eyeWidth, &mockHmdConfig.eyeHeight);
+    }
+    else if (std::string(argv[i]) == "--mock-refresh" && i + 1 < argc)
+    {
+      mockHmdConfig.refreshRate = static_cast<float>(atof(argv[++i]));
+    }
+    else if (std::string(argv[i]) == "--mock-motion" && i + 1 < argc)
+    {
+      mockHmdConfig.motionScript = argv[++i];
+    }
+    // Capture a Chrome trace from launch to exit; T starts and stops one at any time
+    else if (std::string(argv[i]) == "--trace" && i + 1 < argc)
+    {
+      traceAtStart = true;
+      tracePath = argv[++i];
+    }
+    // --record session.input, then --replay session.input to render the same motion again
+    else if (std::string(argv[i]) == "--record" && i + 1 < argc)
+    {
+      inputRecordPath = argv[++i];
+    }
+    else if (std::string(argv[i]) == "--replay" && i + 1 < argc)
+    {
+      inputReplayPath = argv[++i];
+    }
+    else if (std::string(argv[i]) == "--replay-fast")
+    {
+      inputReplayFast = true;
+    }
+    // No window or presentation, e.g. --headless --hmd mock --frames 600 on a build machine
+    else if (std::string(argv[i]) == "--headless")
+    {
+      headless = true;
+    }
+    else if (std::string(argv[i]) == "--frames" && i + 1 < argc)
+    {
+      maxFrames = static_cast<unsigned int>(atoi(argv[++i]));
+    }
+    // The last mirror image as a binary PPM, written at exit
+    else if (std::string(argv[i]) == "--mirror-dump" && i + 1 < argc)
+    {
+      mirrorDumpPath = argv[++i];
+    }
+  }
+
+  // Offline bake: Minimal --bake-cubemaps [dir ...]
+  if (argc > 1 && std::string(argv[1]) == "--bake-cubemaps")
+  {
+    std::vector<std::string> dirs(argv + 2, argv + argc);
+    if (dirs.empty())
+    {
+      dirs = { "cube", "skybox_left", "skybox_right", "skybox_custom" };
+    }
+    result = 0;
+    for (const auto& dir : dirs)
+    {
+      std::cout << "Baking cubemap " << dir << std::endl;
+      if (!bakeCubemapDirectory(dir))
+      {
+        result = -1;
+      }
+    }
+    return result;
+  }
+
+  // Setup failures (no GLFW, no display, no GL context) end the run with their reason
+  try
+  {
+    result = ExampleApp().run();
+  }
+  catch (const std::exception& e)
   {
-    FAIL("Failed to initialize the Oculus SDK");
+    std::cerr << e.what() << std::endl;
   }
-  result = ExampleApp().run();
 
-  ovr_Shutdown();
   return result;
 }
@@ -1,11 +1,20 @@
 #include <stdio.h>
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <algorithm>
+#include <chrono>
 using namespace std;
 
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 #define GLFW_INCLUDE_GLEXT
 #ifdef __APPLE__
 #define GLFW_INCLUDE_GLCOREARB
@@ -16,21 +25,187 @@ using namespace std;
 
 #include "shader.h"
 
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+// Program binaries live in SHADER_CACHE_DIR/<key>.bin where key hashes both
+// sources and the driver strings, so a driver update simply misses the cache.
+static const char* SHADER_CACHE_DIR = "shadercache";
+static const char SHADER_CACHE_MAGIC[4] = { 'P', 'B', 'I', 'N' };
 
-	// Create the shaders
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+// The Camera block and toEye(), next to the vertex shaders
+static const char* CAMERA_SNIPPET = "camera.glsl";
+
+struct ProgramBinaryHeader {
+	char magic[4];
+	uint32_t format;
+	uint32_t length;
+	uint32_t reserved;
+};
+
+static bool shaderCacheEnabled = true;
+static ShaderCacheStats cacheStats = {};
 
+void setShaderCacheEnabled(bool enabled){
+	shaderCacheEnabled = enabled;
+}
+
+const ShaderCacheStats& shaderCacheStats(){
+	return cacheStats;
+}
+
+void printShaderCacheStats(){
+	printf("Shader programs: %u from cache in %.1f ms, %u compiled in %.1f ms, %u cached binaries rejected\n",
+		cacheStats.hits, cacheStats.hitMs, cacheStats.compiled, cacheStats.compileMs, cacheStats.rejected);
+}
+
+static bool readShaderFile(const char * path, std::string& code){
+	std::ifstream stream(path, std::ios::in | std::ios::binary);
+	if(!stream.is_open())
+		return false;
+	std::ostringstream contents;
+	contents << stream.rdbuf();
+	code = contents.str();
+	return true;
+}
+
+// 64 bit FNV-1a
+static void hashBytes(uint64_t& hash, const char * data, size_t length){
+	for(size_t i = 0; i < length; i++){
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ull;
+	}
+	// Separator so that ("ab", "c") and ("a", "bc") hash differently
+	hash ^= 0xff;
+	hash *= 1099511628211ull;
+}
+
+uint64_t hashShaderSources(const std::string& VertexShaderCode, const std::string& FragmentShaderCode){
+	uint64_t hash = 14695981039346656037ull;
+	hashBytes(hash, VertexShaderCode.data(), VertexShaderCode.size());
+	hashBytes(hash, FragmentShaderCode.data(), FragmentShaderCode.size());
+	return hash;
+}
+
+static std::string programCachePath(const std::string& VertexShaderCode, const std::string& FragmentShaderCode){
+	uint64_t hash = hashShaderSources(VertexShaderCode, FragmentShaderCode);
+	const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for(GLenum name : driverStrings){
+		const char * value = (const char *)glGetString(name);
+		std::string str = value ? value : "";
+		hashBytes(hash, str.data(), str.size());
+	}
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+	return std::string(SHADER_CACHE_DIR) + "/" + key + ".bin";
+}
+
+static bool programBinarySupported(){
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+// Returns a linked program, or 0 if there is no binary or the driver rejects it
+static GLuint loadProgramBinary(const std::string& path){
+	FILE * fp = fopen(path.c_str(), "rb");
+	if(!fp)
+		return 0;
+
+	// The length is only trusted as far as the file backs it, so a corrupt or
+	// truncated binary is rejected instead of sizing the buffer
+	fseek(fp, 0, SEEK_END);
+	long fileSize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	ProgramBinaryHeader header;
+	std::vector<char> binary;
+	bool ok = fileSize >= (long)sizeof(header) && fread(&header, sizeof(header), 1, fp) == 1 &&
+		std::equal(header.magic, header.magic + 4, SHADER_CACHE_MAGIC) &&
+		header.length <= (unsigned long)fileSize - sizeof(header);
+	if(ok){
+		binary.resize(header.length);
+		ok = header.length > 0 && fread(&binary[0], header.length, 1, fp) == 1;
+	}
+	fclose(fp);
+	if(!ok){
+		cacheStats.rejected++;
+		return 0;
+	}
+
+	GLuint ProgramID = glCreateProgram();
+	glProgramBinary(ProgramID, header.format, &binary[0], header.length);
+	GLint Result = GL_FALSE;
+	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	if(Result != GL_TRUE){
+		// Usually a driver update the driver strings did not reflect; recompile
+		glDeleteProgram(ProgramID);
+		cacheStats.rejected++;
+		return 0;
+	}
+	return ProgramID;
+}
+
+static void saveProgramBinary(GLuint ProgramID, const std::string& path){
+	GLint length = 0;
+	glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0)
+		return;
+
+	ProgramBinaryHeader header = {};
+	std::copy(SHADER_CACHE_MAGIC, SHADER_CACHE_MAGIC + 4, header.magic);
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(ProgramID, length, NULL, &format, &binary[0]);
+	header.format = format;
+	header.length = (uint32_t)length;
+
+#ifdef _WIN32
+	_mkdir(SHADER_CACHE_DIR);
+#else
+	mkdir(SHADER_CACHE_DIR, 0755);
+#endif
+	// Written next to the final path and renamed over it, so an interrupted
+	// write never leaves a torn binary behind
+	std::string tmpPath = path + ".tmp";
+	FILE * fp = fopen(tmpPath.c_str(), "wb");
+	if(!fp){
+		printf("Unable to write shader cache %s\n", tmpPath.c_str());
+		return;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(&binary[0], length, 1, fp) == 1;
+	ok = fclose(fp) == 0 && ok;
+	if(!ok){
+		printf("Unable to write shader cache %s\n", tmpPath.c_str());
+		remove(tmpPath.c_str());
+		return;
+	}
+	remove(path.c_str());
+	if(rename(tmpPath.c_str(), path.c_str()) != 0)
+		printf("Unable to write shader cache %s\n", path.c_str());
+}
+
+// Inserts snippet after the #version line, which has to stay first, and then
+// restores the line numbers so compile errors still point into the shader's file
+static void spliceAfterVersion(std::string& code, const std::string& snippet){
+	size_t at = 0;
+	int line = 1;
+	if(code.compare(0, 8, "#version") == 0){
+		at = code.find('\n');
+		at = at == std::string::npos ? code.size() : at + 1;
+		line = 2;
+	}
+	code.insert(at, snippet + "\n#line " + std::to_string(line) + "\n");
+}
+
+GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+	std::string VertexShaderCode, FragmentShaderCode;
+	if(!readShaderSources(vertex_file_path, fragment_file_path, VertexShaderCode, FragmentShaderCode))
+		return 0;
+	return LoadShadersFromSource(VertexShaderCode, FragmentShaderCode, vertex_file_path, fragment_file_path);
+}
+
+bool readShaderSources(const char * vertex_file_path, const char * fragment_file_path,
+	std::string& VertexShaderCode, std::string& FragmentShaderCode){
 	// Read the Vertex Shader code from the file
-	std::string VertexShaderCode;
-	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-	if(VertexShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(VertexShaderStream, Line))
-			VertexShaderCode += "\n" + Line;
-		VertexShaderStream.close();
-	}else{
+	if(!readShaderFile(vertex_file_path, VertexShaderCode)){
 		printf("Impossible to open %s. Check to make sure the file exists and you passed in the right filepath!\n", vertex_file_path);
 		printf("The current working directory is:");
 #ifdef _WIN32
@@ -39,19 +214,50 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 		system("pwd");
 #endif
 		getchar();
-		return 0;
+		return false;
 	}
 
+	// Every vertex shader gets the shared camera snippet from its own directory
+	std::string snippetPath(vertex_file_path);
+	size_t slash = snippetPath.find_last_of("/\\");
+	snippetPath = (slash == std::string::npos ? std::string() : snippetPath.substr(0, slash + 1)) + CAMERA_SNIPPET;
+	std::string snippet;
+	if(!readShaderFile(snippetPath.c_str(), snippet)){
+		printf("Impossible to open %s, which every vertex shader includes\n", snippetPath.c_str());
+		return false;
+	}
+	spliceAfterVersion(VertexShaderCode, snippet);
+
 	// Read the Fragment Shader code from the file
-	std::string FragmentShaderCode;
-	std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-	if(FragmentShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(FragmentShaderStream, Line))
-			FragmentShaderCode += "\n" + Line;
-		FragmentShaderStream.close();
+	readShaderFile(fragment_file_path, FragmentShaderCode);
+	return true;
+}
+
+GLuint LoadShadersFromSource(const std::string& VertexShaderCode, const std::string& FragmentShaderCode,
+	const char * vertex_file_path, const char * fragment_file_path){
+	auto start = std::chrono::steady_clock::now();
+
+	// Try the program binary cache first. With the cache disabled we still
+	// compile with the retrievable hint and refresh the stored binary.
+	bool useCache = programBinarySupported();
+	std::string cachePath;
+	if(useCache)
+		cachePath = programCachePath(VertexShaderCode, FragmentShaderCode);
+	if(useCache && shaderCacheEnabled){
+		GLuint ProgramID = loadProgramBinary(cachePath);
+		if(ProgramID){
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			cacheStats.hits++;
+			cacheStats.hitMs += ms;
+			printf("Loaded program %s + %s from shader cache (%.2f ms)\n", vertex_file_path, fragment_file_path, ms);
+			return ProgramID;
+		}
 	}
 
+	// Create the shaders
+	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
 
@@ -100,22 +306,33 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 	GLuint ProgramID = glCreateProgram();
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
+	if(useCache)
+		glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(ProgramID);
 
 	// Check the program
 	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	GLint Linked = Result;
 	glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
 	if ( InfoLogLength > 0 ){
 		std::vector<char> ProgramErrorMessage(InfoLogLength+1);
 		glGetProgramInfoLog(ProgramID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
 		printf("%s\n", &ProgramErrorMessage[0]);
 	}
-	
+
 	glDetachShader(ProgramID, VertexShaderID);
 	glDetachShader(ProgramID, FragmentShaderID);
-	
+
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	if(useCache && Linked == GL_TRUE)
+		saveProgramBinary(ProgramID, cachePath);
+
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	cacheStats.compiled++;
+	cacheStats.compileMs += ms;
+	printf("Built program %s + %s from source (%.2f ms)\n", vertex_file_path, fragment_file_path, ms);
+
 	return ProgramID;
 }
@@ -1,6 +1,37 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <stdint.h>
+#include <string>
+
 GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path);
 
+// The two halves of LoadShaders, for callers that need the source text first.
+// readShaderSources splices camera.glsl, from the vertex shader's directory,
+// in after the vertex shader's #version line. The file paths passed to
+// LoadShadersFromSource are only used for logging.
+bool readShaderSources(const char * vertex_file_path, const char * fragment_file_path,
+	std::string& VertexShaderCode, std::string& FragmentShaderCode);
+GLuint LoadShadersFromSource(const std::string& VertexShaderCode, const std::string& FragmentShaderCode,
+	const char * vertex_file_path, const char * fragment_file_path);
+
+// Content hash of a vertex/fragment pair
+uint64_t hashShaderSources(const std::string& VertexShaderCode, const std::string& FragmentShaderCode);
+
+// Linked programs are cached as driver binaries under shadercache/, keyed by a
+// hash of both sources and the GL vendor, renderer and version strings. Turn
+// the cache off to measure a cold start; binaries are still written.
+void setShaderCacheEnabled(bool enabled);
+
+struct ShaderCacheStats {
+	unsigned int hits;
+	unsigned int compiled;
+	unsigned int rejected;
+	double hitMs;
+	double compileMs;
+};
+
+const ShaderCacheStats& shaderCacheStats();
+void printShaderCacheStats();
+
 #endif
@@ -10,8 +10,7 @@ layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
 
 // Uniform variables can be updated by fetching their location and passing values to that location
-uniform mat4 projection;
-uniform mat4 modelview;
+uniform mat4 model;
 
 // Outputs of the vertex shader are the inputs of the same name of the fragment shader.
 // The default output, gl_Position, should be assigned something. You can define as many
@@ -21,6 +20,7 @@ out vec3 vertNormal;
 void main()
 {
     // OpenGL maintains the D matrix so you only need to multiply by P, V (aka C inverse), and M
-    gl_Position = projection * modelview * vec4(position.x, position.y, position.z, 1.0);
+    int eye = gl_InstanceID % eyeCount;
+    gl_Position = toEye(viewProjection[eye] * model * vec4(position.x, position.y, position.z, 1.0), eye);
 	vertNormal = normal;
 }
@@ -0,0 +1,44 @@
+#version 410 core
+// NOTE: Do NOT use any version older than 330! Bad things will happen!
+
+// This is an example vertex shader. GLSL is very similar to C.
+// You can define extra functions if needed, and the main() function is
+// called when the vertex shader gets run.
+// The vertex shader gets called once per vertex.
+
+// The packed vertex layout of VertexPacking.h; shader_cursor.vert is the same
+// shader for full float vertices. Positions are 16 bit normalised across the
+// mesh's bounds with the bitangent's handedness in w, normals octahedral
+// encoded as integers in +-32767.
+layout (location = 0) in vec4 packedPosition;
+layout (location = 1) in vec2 packedNormal;
+
+// Uniform variables can be updated by fetching their location and passing values to that location
+uniform mat4 model;
+// The mesh's bounds: position = positionOffset + positionScale * packedPosition.xyz
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+// Octahedral encoding back to a unit vector
+vec3 octDecode(vec2 encoded)
+{
+    vec2 e = max(encoded / 32767.0, vec2(-1.0));
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+    return normalize(v);
+}
+
+// Outputs of the vertex shader are the inputs of the same name of the fragment shader.
+// The default output, gl_Position, should be assigned something. You can define as many
+// extra outputs as you need.
+out vec3 vertNormal;
+
+void main()
+{
+    // OpenGL maintains the D matrix so you only need to multiply by P, V (aka C inverse), and M
+    int eye = gl_InstanceID % eyeCount;
+    vec3 position = positionOffset + positionScale * packedPosition.xyz;
+    gl_Position = toEye(viewProjection[eye] * model * vec4(position.x, position.y, position.z, 1.0), eye);
+	vertNormal = octDecode(packedNormal);
+}
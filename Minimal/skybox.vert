@@ -11,12 +11,15 @@ layout (location = 1) in vec3 normal;
 
 out vec3 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+uniform mat4 model;
+// Draws only this eye when 0 or 1, as the two skyboxes differ; -1 draws every eye
+uniform int onlyEye;
 
 void main()
 {
     TexCoords = position;
-    gl_Position = projection * view * vec4(position, 1.0);
+    // Remove the view translation so the sky stays at infinity
+    int eye = onlyEye >= 0 ? onlyEye : gl_InstanceID % eyeCount;
+    gl_Position = toEye(projection[eye] * mat4(mat3(view[eye])) * model * vec4(position, 1.0), eye);
     //gl_Position = pos.xyww;
 }  
\ No newline at end of file
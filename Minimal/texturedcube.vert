@@ -0,0 +1,19 @@
+#version 330 core
+// NOTE: Do NOT use any version older than 330! Bad things will happen!
+
+// Cubemapped cubes placed in the world: the same as skybox.vert, but with the
+// full view transform.
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+
+out vec3 TexCoords;
+
+uniform mat4 model;
+
+void main()
+{
+    TexCoords = position;
+    int eye = gl_InstanceID % eyeCount;
+    gl_Position = toEye(viewProjection[eye] * model * vec4(position, 1.0), eye);
+}
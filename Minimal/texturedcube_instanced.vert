@@ -0,0 +1,23 @@
+#version 330 core
+// NOTE: Do NOT use any version older than 330! Bad things will happen!
+
+// texturedcube.vert for TexturedCube::drawInstanced: each instance brings its
+// own model matrix as a per-instance attribute, and the model uniform places
+// the whole set.
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+// Takes locations 2 to 5, one column each
+layout (location = 2) in mat4 instanceModel;
+
+out vec3 TexCoords;
+
+uniform mat4 model;
+
+void main()
+{
+    TexCoords = position;
+    // instanceModel advances once every eyeCount instances
+    int eye = gl_InstanceID % eyeCount;
+    gl_Position = toEye(viewProjection[eye] * model * instanceModel * vec4(position, 1.0), eye);
+}